@@ -0,0 +1,83 @@
+#pragma once
+
+#include <rsfs/RSFileSystem.hpp>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+ * The time to wait after the last change to the cache files before reloading.
+ */
+constexpr const auto WATCH_SETTLE_TIME = std::chrono::milliseconds(500);
+
+namespace rsfs
+{
+    /**
+     * Watches the directory of a filesystem with inotify, and reloads the filesystem once its files have stopped
+     * changing. Only supported on Linux.
+     */
+    class CacheWatcher
+    {
+    public:
+        /**
+         * The function invoked with the ids of the indices that were reloaded.
+         */
+        using Callback = std::function<void(const std::vector<size_t>& reloaded)>;
+
+        /**
+         * Starts watching a filesystem.
+         * @param fs        The filesystem to reload.
+         * @param settle    The time to wait after the last change before reloading.
+         * @param callback  The function invoked on the watcher thread after a reload that changed any indices.
+         * @throws std::runtime_error   If the filesystem isn't in the sector layout, or can't be watched.
+         */
+        explicit CacheWatcher(RSFileSystem& fs, std::chrono::milliseconds settle = WATCH_SETTLE_TIME,
+                              Callback callback = {});
+
+        /**
+         * Stops watching the filesystem.
+         */
+        ~CacheWatcher();
+
+        CacheWatcher(const CacheWatcher&) = delete;
+        CacheWatcher& operator=(const CacheWatcher&) = delete;
+
+    private:
+        /**
+         * Waits for changes to the cache files, and reloads the filesystem once they settle.
+         */
+        void run();
+
+        /**
+         * The filesystem to reload.
+         */
+        RSFileSystem& fs_;
+
+        /**
+         * The time to wait after the last change before reloading.
+         */
+        std::chrono::milliseconds settle_;
+
+        /**
+         * The function invoked after a reload.
+         */
+        Callback callback_;
+
+        /**
+         * The inotify file descriptor.
+         */
+        int inotify_{ -1 };
+
+        /**
+         * The eventfd used to stop the watcher thread.
+         */
+        int wake_{ -1 };
+
+        /**
+         * The watcher thread.
+         */
+        std::thread thread_;
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <rsfs/jag/Extraction.hpp>
+#include <rsfs/jag/IoHints.hpp>
+#include <rsfs/store/Store.hpp>
+
+#include <string>
+#include <vector>
+
+namespace rsfs
+{
+    /**
+     * The options used when opening a filesystem.
+     */
+    struct FileSystemOptions
+    {
+        /**
+         * The path to a metadata snapshot. When set, the reference tables of unchanged indices are restored from
+         * the snapshot instead of being decompressed and parsed, and the snapshot is rewritten if any index has
+         * changed since it was written.
+         */
+        std::string metadataSnapshot;
+
+        /**
+         * If the reference table of each index should only be read and parsed the first time the index's archives
+         * or metadata are accessed, rather than when the filesystem is opened. Index files are also opened on
+         * demand. A lazily loaded filesystem restores indices from the metadata snapshot, but never rewrites it.
+         */
+        bool lazy{ false };
+
+        /**
+         * The path to a file of XTEA keys, used to decipher encrypted archives such as map landscapes. See
+         * XteaKeyStore::load for the supported formats.
+         */
+        std::string xteaKeys;
+
+        /**
+         * When the files in an archive are extracted. Extracting files on demand avoids splitting every file in an
+         * archive when only a few of them are used.
+         */
+        Extraction extraction{ EAGER };
+
+        /**
+         * The layout of the data files, when the filesystem is opened from a path. A filesystem that is opened from
+         * a store ignores this.
+         */
+        StoreLayout layout{ SECTOR };
+
+        /**
+         * If the compressed container of every archive should be read into one contiguous arena in memory when
+         * the filesystem is opened. Nothing is read from disk afterwards, and memory use stays close to the size of
+         * the data files, as long as archives are read through IndexFile::acquireArchive rather than getArchive.
+         * Reloading the filesystem has no effect in this mode.
+         */
+        bool inMemory{ false };
+
+        /**
+         * The number of decompressed archives that IndexFile::acquireArchive keeps in a cache shared by every
+         * index, or 0 to decompress archives each time they are acquired.
+         */
+        size_t hotCacheSize{ 0 };
+
+        /**
+         * How the data file will be read, when the filesystem is opened from a path in the sector layout. Bulk jobs
+         * such as exports and verification should read sequentially, and servers randomly. The hints also apply to
+         * the data file that an AsyncReader reads through io_uring.
+         */
+        IoHints ioHints{};
+
+        /**
+         * The indices whose archives are read into the page cache in the background when the filesystem is opened,
+         * when it is opened from a path in the sector layout.
+         */
+        std::vector<size_t> preloadIndices;
+    };
+}
@@ -1,16 +1,23 @@
 #pragma once
 
-#include <rsfs/jag/DataFile.hpp>
+#include <rsfs/FileSystemOptions.hpp>
+#include <rsfs/crypto/XteaKeyStore.hpp>
+#include <rsfs/jag/ArchiveCache.hpp>
 #include <rsfs/jag/IndexData.hpp>
 #include <rsfs/jag/IndexFile.hpp>
+#include <rsfs/store/Store.hpp>
 
 #include <array>
-#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <string_view>
 #include <vector>
 
 namespace rsfs
 {
+    class MetadataSnapshot;
+
     /**
      * Represents the RuneScape virtual filesystem, and offers an interface for retrieving data from specific
      * archives or files within an index.
@@ -20,9 +27,17 @@ namespace rsfs
     public:
         /**
          * Initialises the RuneScape filesystem.
-         * @param path  The path to the RuneScape data files.
+         * @param path      The path to the RuneScape data files.
+         * @param options   The options to open the filesystem with.
+         */
+        explicit RSFileSystem(const std::string_view& path, FileSystemOptions options = {});
+
+        /**
+         * Initialises the RuneScape filesystem from a store, such as an in-memory store.
+         * @param store     The store that the data files are read from.
+         * @param options   The options to open the filesystem with.
          */
-        explicit RSFileSystem(const std::string_view& path);
+        explicit RSFileSystem(std::unique_ptr<Store> store, FileSystemOptions options = {});
 
         /**
          * Handles the destruction of this filesystem.
@@ -36,6 +51,54 @@ namespace rsfs
          */
         [[nodiscard]] IndexFile& getIndex(size_t id) const;
 
+        /**
+         * Gets the number of indices in this filesystem.
+         * @return  The number of indices.
+         */
+        [[nodiscard]] size_t indexCount() const
+        {
+            return indexCount_;
+        }
+
+        /**
+         * Gets the store that the data files are read from.
+         * @return  The store.
+         */
+        [[nodiscard]] Store& store() const
+        {
+            return *store_;
+        }
+
+        /**
+         * Re-reads the metadata index, and reloads the indices whose reference tables have changed. Only the
+         * archives whose revision or checksum changed are invalidated, and each index swaps in its new reference
+         * table atomically, so this is safe to call while other threads are reading from the filesystem. Archives
+         * that were replaced remain valid until reclaim() is called.
+         * @return  The ids of the indices that were reloaded.
+         */
+        std::vector<size_t> reload();
+
+        /**
+         * Frees the reference tables and archives that have been replaced by a reload. The caller must ensure that
+         * no references to archives from before the reload are still in use.
+         */
+        void reclaim();
+
+        /**
+         * Gets the path to the RuneScape data files. This is empty if the filesystem was opened from a store.
+         * @return  The path.
+         */
+        [[nodiscard]] const std::string& path() const
+        {
+            return path_;
+        }
+
+        /**
+         * Sets the keys used to decipher encrypted archives. This must not be called while archives are being read.
+         * @param keys  The key store.
+         */
+        void setKeys(XteaKeyStore keys);
+
         /**
          * Builds the checksum table for this file system.
          * @param whirlpool If we should include a whirlpool digest in this checksum table.
@@ -49,21 +112,65 @@ namespace rsfs
         [[nodiscard]] RSBuffer checksumTable() const;
 
     private:
+        friend class MetadataSnapshot;
+
         /**
-         * The file stream to the asset data file.
+         * The path to the RuneScape data files.
          */
-        DataFile* dataFile_;
+        std::string path_;
 
         /**
-         * The metadata index.
+         * The options the filesystem was opened with.
          */
-        IndexFile* metadataIndex_;
+        FileSystemOptions options_;
+
+        /**
+         * The store that the data files are read from.
+         */
+        std::unique_ptr<Store> store_;
 
         /**
          * Loads all of the cache indices into memory.
          */
         void loadIndices();
 
+        /**
+         * Loads a single index, restoring it from a metadata snapshot if its reference table hasn't changed.
+         * @param index     The index to load.
+         * @param snapshot  The metadata snapshot, or null if there isn't one.
+         * @return          If the index was restored from the snapshot.
+         */
+        bool loadIndex(IndexFile& index, const MetadataSnapshot* snapshot);
+
+        /**
+         * Decompresses and parses the reference table of an index.
+         * @param index The index.
+         * @param data  The compressed reference table.
+         * @return      The number of archives that were added, changed or removed.
+         */
+        size_t parseIndex(IndexFile& index, RSBuffer& data) const;
+
+        /**
+         * Calculates the checksum of a compressed reference table.
+         * @param data  The compressed reference table.
+         * @return      The CRC32 checksum.
+         */
+        static uint32_t tableChecksum(const RSBuffer& data);
+
+        /**
+         * Opens the store for a path.
+         * @param path      The path to the RuneScape data files.
+         * @param options   The options that the filesystem is opened with.
+         * @return          The store.
+         */
+        static std::unique_ptr<Store> openStore(const std::string_view& path, const FileSystemOptions& options);
+
+        /**
+         * Opens the metadata snapshot, if one was requested.
+         * @return  The snapshot, or null if there isn't one or it couldn't be opened.
+         */
+        [[nodiscard]] std::unique_ptr<MetadataSnapshot> openSnapshot() const;
+
         /**
          * Gets an index with a specified id
          * @param id    The id of the index.
@@ -81,6 +188,31 @@ namespace rsfs
          */
         std::vector<IndexFile*> indices_;
 
+        /**
+         * The metadata snapshot that lazily loaded indices are restored from.
+         */
+        std::unique_ptr<MetadataSnapshot> snapshot_;
+
+        /**
+         * The keys used to decipher encrypted archives.
+         */
+        XteaKeyStore keys_;
+
+        /**
+         * The cache of recently acquired archives, or null if there isn't one.
+         */
+        std::unique_ptr<ArchiveCache> hotCache_;
+
+        /**
+         * The checksum of each index's compressed reference table when it was last loaded.
+         */
+        std::vector<uint32_t> tableChecksums_;
+
+        /**
+         * The mutex guarding reloads.
+         */
+        std::mutex reloadMutex_;
+
         /**
          * The checksum table buffer.
          */
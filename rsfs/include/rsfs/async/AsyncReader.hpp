@@ -0,0 +1,196 @@
+#pragma once
+
+#include <rsfs/RSFileSystem.hpp>
+#include <rsfs/io/RSBuffer.hpp>
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+
+namespace rsfs
+{
+    class IoUringBackend;
+    class AsyncReader;
+    class SectorStore;
+
+    /**
+     * An awaitable that reads and decompresses an archive when awaited from a coroutine. The coroutine is
+     * resumed on the thread that completed the read.
+     */
+    class ArchiveAwaitable
+    {
+    public:
+        /**
+         * Creates an awaitable for an archive.
+         * @param reader    The reader to read with.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         */
+        ArchiveAwaitable(AsyncReader& reader, size_t index, size_t archive)
+            : reader_(reader), index_(index), archive_(archive)
+        {
+        }
+
+        /**
+         * The read is always asynchronous, so the coroutine is always suspended.
+         * @return  False.
+         */
+        [[nodiscard]] bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        /**
+         * Starts the read, and resumes the coroutine once it completes.
+         * @param handle    The suspended coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> handle);
+
+        /**
+         * Gets the result of the read.
+         * @return  The decompressed archive data.
+         */
+        RSBuffer await_resume();
+
+    private:
+        /**
+         * The reader to read with.
+         */
+        AsyncReader& reader_;
+
+        /**
+         * The index id.
+         */
+        size_t index_;
+
+        /**
+         * The archive id.
+         */
+        size_t archive_;
+
+        /**
+         * The decompressed archive data.
+         */
+        RSBuffer result_{ 0 };
+
+        /**
+         * The error that occurred during the read, if any.
+         */
+        std::exception_ptr error_;
+    };
+
+    /**
+     * Reads and decompresses archives without blocking the calling thread. On Linux, the sector chains are
+     * read through io_uring when it is available, and otherwise the reads are performed on a thread pool.
+     * Decompression is always performed on the thread pool.
+     */
+    class AsyncReader
+    {
+    public:
+        /**
+         * The function invoked when a read completes. If the read failed, the error is set and the buffer is empty.
+         */
+        using Callback = std::function<void(std::exception_ptr error, RSBuffer data)>;
+
+        /**
+         * Creates an asynchronous reader for a filesystem.
+         * @param fs            The filesystem to read from.
+         * @param threads       The number of worker threads, or 0 to use the number of hardware threads.
+         * @param queueDepth    The maximum number of sector reads submitted to io_uring at once.
+         */
+        explicit AsyncReader(RSFileSystem& fs, size_t threads = 0, size_t queueDepth = 256);
+
+        /**
+         * Waits for all outstanding reads to complete, and destroys this reader.
+         */
+        ~AsyncReader();
+
+        /**
+         * Reads and decompresses an archive, invoking a callback once it has completed.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param callback  The callback.
+         */
+        void read(size_t index, size_t archive, Callback callback);
+
+        /**
+         * Reads and decompresses an archive.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The future decompressed archive data.
+         */
+        std::future<RSBuffer> read(size_t index, size_t archive);
+
+        /**
+         * Reads and decompresses an archive from a coroutine.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The awaitable decompressed archive data.
+         */
+        [[nodiscard]] ArchiveAwaitable awaitArchive(size_t index, size_t archive)
+        {
+            return { *this, index, archive };
+        }
+
+        /**
+         * Checks if the sector chains are being read through io_uring.
+         * @return  If io_uring is being used.
+         */
+        [[nodiscard]] bool usingIoUring() const
+        {
+            return ring_ != nullptr;
+        }
+
+    private:
+        /**
+         * Deciphers and decompresses a compressed archive on the thread pool, and passes it to a callback.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param data      The compressed archive data.
+         * @param callback  The callback.
+         */
+        void decompress(size_t index, size_t archive, RSBuffer data, Callback callback);
+
+        /**
+         * Reopens the data file of the io_uring backend if the store has reopened or grown its own since, such as
+         * when the filesystem has been reloaded.
+         */
+        void refreshRing();
+
+        /**
+         * The filesystem to read from.
+         */
+        RSFileSystem& fs_;
+
+        /**
+         * The filesystem's store, if it is in the sector layout that io_uring reads from.
+         */
+        SectorStore* sectors_;
+
+        /**
+         * The generation of the store's data file that the io_uring backend last opened.
+         */
+        std::atomic<uint64_t> generation_;
+
+        /**
+         * The mutex serialising reopens of the io_uring backend's data file.
+         */
+        std::mutex refreshMutex_;
+
+        /**
+         * The pool used for decompression, and for reading when io_uring is unavailable.
+         */
+        boost::asio::thread_pool pool_;
+
+        /**
+         * The io_uring backend, or null if it is unavailable.
+         */
+        std::unique_ptr<IoUringBackend> ring_;
+    };
+}
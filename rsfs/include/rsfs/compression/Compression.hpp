@@ -1,8 +1,23 @@
 #pragma once
 
+#include <rsfs/compression/CompressionType.hpp>
+#include <rsfs/compression/ContainerHeader.hpp>
 #include <rsfs/io/RSBuffer.hpp>
 
 #include <array>
+#include <optional>
+#include <span>
+#include <vector>
+
+/**
+ * The compression level used when none is specified.
+ */
+constexpr const auto DEFAULT_COMPRESSION_LEVEL = 6;
+
+/**
+ * The highest compression level.
+ */
+constexpr const auto MAX_COMPRESSION_LEVEL = 9;
 
 namespace rsfs
 {
@@ -19,5 +34,63 @@ namespace rsfs
          * @return      The decompressed buffer.
          */
         static RSBuffer decompress(RSBuffer& buf);
+
+        /**
+         * Decompresses a container in place, without copying it into a buffer first.
+         * @param container The compressed container.
+         * @return          The decompressed data.
+         */
+        static RSBuffer decompress(std::span<const char> container);
+
+        /**
+         * Compresses data into a container that decompress() reads back. The encoder state is kept per thread and
+         * reused, so this is cheap to call repeatedly, and safe to call from multiple threads.
+         * @param data      The data to compress.
+         * @param type      The type of compression.
+         * @param revision  The revision to append to the container, if any.
+         * @param level     The compression level, from 1 to 9, which is the preset for LZMA. BZIP2 containers
+         *                  always use a block size of 100k, as their header is implied.
+         * @return          The container.
+         */
+        static RSBuffer compress(const RSBuffer& data, CompressionType type,
+                                 std::optional<uint16_t> revision = std::nullopt,
+                                 int level                        = DEFAULT_COMPRESSION_LEVEL);
+
+        /**
+         * Compresses many buffers in parallel, such as every archive that has changed in a build.
+         * @param data      The data to compress.
+         * @param type      The type of compression.
+         * @param threads   The number of threads to compress with, or 0 to use the number of hardware threads.
+         * @param level     The compression level, from 1 to 9.
+         * @return          The containers, in the same order as the data, without revisions.
+         */
+        static std::vector<RSBuffer> compressAll(std::span<const RSBuffer> data, CompressionType type,
+                                                 size_t threads = 0, int level = DEFAULT_COMPRESSION_LEVEL);
+
+        /**
+         * Decompresses many containers in parallel.
+         * @param containers    The containers to decompress.
+         * @param threads       The number of threads to decompress with, or 0 to use the number of hardware threads.
+         * @return              The decompressed data, in the same order as the containers.
+         * @throws std::runtime_error   If any container couldn't be decompressed.
+         */
+        static std::vector<RSBuffer> decompressAll(std::span<const RSBuffer> containers, size_t threads = 0);
+
+        /**
+         * Reads the unencrypted header at the start of a container. The compression type isn't checked.
+         * @param data      The start of the container.
+         * @param length    The number of bytes available.
+         * @return          The header.
+         * @throws std::runtime_error   If the container is too short to have a header.
+         */
+        static ContainerHeader containerHeader(const char* data, size_t length);
+
+        /**
+         * Gets the name of a compression type, as used by the tools.
+         * @param type  The compression type.
+         * @return      The name.
+         * @throws std::out_of_range    If the type is unknown.
+         */
+        static const char* typeName(CompressionType type);
     };
 }
\ No newline at end of file
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <cstdint>
+
+/**
+ * The number of supported compression types.
+ */
+constexpr const auto COMPRESSION_TYPES = 4;
+
 namespace rsfs
 {
     /**
@@ -10,5 +17,6 @@ namespace rsfs
         NONE,
         BZIP2,
         GZIP,
+        LZMA,
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <rsfs/compression/CompressionType.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The length of the header at the start of every container: the compression type and the compressed length. This
+ * part of the header is never encrypted.
+ */
+constexpr const auto CONTAINER_HEADER_LENGTH = 5;
+
+/**
+ * The length of the decompressed length that follows the header of a compressed container.
+ */
+constexpr const auto DECOMPRESSED_LENGTH_SIZE = 4;
+
+/**
+ * The length of the header of a compressed container: the type, the compressed length and the decompressed length.
+ */
+constexpr const auto COMPRESSED_HEADER_LENGTH = CONTAINER_HEADER_LENGTH + DECOMPRESSED_LENGTH_SIZE;
+
+/**
+ * The length of the revision that may follow the payload of a container.
+ */
+constexpr const auto CONTAINER_REVISION_SIZE = 2;
+
+namespace rsfs
+{
+    /**
+     * The unencrypted header at the start of an archive container.
+     */
+    struct ContainerHeader
+    {
+        /**
+         * The compression type, which may not be a known type.
+         */
+        CompressionType type{ NONE };
+
+        /**
+         * The length of the compressed payload.
+         */
+        uint32_t compressedLength{ 0 };
+
+        /**
+         * Gets the length of the container's header, including the decompressed length if it is compressed.
+         * @return  The header length.
+         */
+        [[nodiscard]] size_t headerLength() const
+        {
+            return type == NONE ? CONTAINER_HEADER_LENGTH : COMPRESSED_HEADER_LENGTH;
+        }
+
+        /**
+         * Gets the offset of the end of the payload, which is where the revision starts if the container has one.
+         * @return  The end of the payload.
+         */
+        [[nodiscard]] size_t payloadEnd() const
+        {
+            return headerLength() + compressedLength;
+        }
+
+        /**
+         * Gets the length of the part of the container that is encrypted, which follows the unencrypted header.
+         * @return  The encrypted length.
+         */
+        [[nodiscard]] size_t encryptedLength() const
+        {
+            return payloadEnd() - CONTAINER_HEADER_LENGTH;
+        }
+    };
+}
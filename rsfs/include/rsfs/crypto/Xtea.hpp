@@ -0,0 +1,71 @@
+#pragma once
+
+#include <rsfs/io/RSBuffer.hpp>
+
+#include <array>
+#include <cstdint>
+
+/**
+ * The size of an XTEA block, in bytes.
+ */
+constexpr const auto XTEA_BLOCK_SIZE = 8;
+
+/**
+ * The number of XTEA rounds.
+ */
+constexpr const auto XTEA_ROUNDS = 32;
+
+/**
+ * The XTEA key schedule constant.
+ */
+constexpr const uint32_t XTEA_DELTA = 0x9E3779B9;
+
+namespace rsfs
+{
+    /**
+     * A 128-bit XTEA key.
+     */
+    using XteaKey = std::array<uint32_t, 4>;
+
+    /**
+     * A static class that is responsible for enciphering and deciphering XTEA encrypted data. Blocks are stored as
+     * two big-endian words, and any trailing bytes that don't fill a whole block are left as plaintext.
+     */
+    class Xtea
+    {
+    public:
+        /**
+         * Deciphers a series of blocks in place. Several blocks are deciphered at once where the CPU supports it.
+         * @param data      The data to decipher.
+         * @param length    The number of bytes to decipher.
+         * @param key       The key.
+         */
+        static void decipher(char* data, size_t length, const XteaKey& key);
+
+        /**
+         * Enciphers a series of blocks in place.
+         * @param data      The data to encipher.
+         * @param length    The number of bytes to encipher.
+         * @param key       The key.
+         */
+        static void encipher(char* data, size_t length, const XteaKey& key);
+
+        /**
+         * Deciphers the payload of an archive container in place. The compression type and compressed length that
+         * prefix the container, and the revision that may follow it, are not encrypted.
+         * @param container The container.
+         * @param key       The key.
+         */
+        static void decipherContainer(RSBuffer& container, const XteaKey& key);
+
+        /**
+         * Checks if a key is the zero key, which is used to mark data that isn't encrypted.
+         * @param key   The key.
+         * @return      If the key is the zero key.
+         */
+        [[nodiscard]] static bool isZero(const XteaKey& key)
+        {
+            return (key[0] | key[1] | key[2] | key[3]) == 0;
+        }
+    };
+}
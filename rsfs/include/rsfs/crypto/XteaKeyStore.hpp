@@ -0,0 +1,94 @@
+#pragma once
+
+#include <rsfs/crypto/Xtea.hpp>
+
+#include <map>
+#include <string>
+#include <utility>
+
+namespace rsfs
+{
+    /**
+     * A collection of the XTEA keys used to decipher encrypted archives. Keys are either stored for a specific
+     * archive in an index, or for a map region, in which case they apply to the region's landscape archive in the
+     * maps index, which is found through its name hash.
+     */
+    class XteaKeyStore
+    {
+    public:
+        /**
+         * Loads a key store from a file. Files ending in ".json" are loaded as JSON, and all other files are
+         * loaded as binary.
+         * @param path  The path to the keys file.
+         * @return      The key store.
+         */
+        static XteaKeyStore load(const std::string& path);
+
+        /**
+         * Loads a key store from a JSON file, containing an array of objects with either an "archive" and "group",
+         * or a "mapsquare" or "region", along with a "key" or "keys" array of four integers.
+         * @param path  The path to the keys file.
+         * @return      The key store.
+         */
+        static XteaKeyStore loadJson(const std::string& path);
+
+        /**
+         * Loads a key store from a binary file, containing a series of big-endian records of a region id followed
+         * by the four words of its key.
+         * @param path  The path to the keys file.
+         * @return      The key store.
+         */
+        static XteaKeyStore loadBinary(const std::string& path);
+
+        /**
+         * Stores the key for a specific archive.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param key       The key.
+         */
+        void put(size_t index, size_t archive, const XteaKey& key);
+
+        /**
+         * Stores the key for a map region.
+         * @param region    The region id, with the region's x coordinate in the upper byte and y in the lower.
+         * @param key       The key.
+         */
+        void putRegion(uint32_t region, const XteaKey& key);
+
+        /**
+         * Finds the key for an archive.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param nameHash  The name hash of the archive.
+         * @return          The key, or null if the archive has no key.
+         */
+        [[nodiscard]] const XteaKey* find(size_t index, size_t archive, int nameHash) const;
+
+        /**
+         * Gets the number of keys in this store.
+         * @return  The number of keys.
+         */
+        [[nodiscard]] size_t size() const
+        {
+            return archives_.size() + landscapes_.size();
+        }
+
+        /**
+         * Calculates the name hash of a region's landscape archive.
+         * @param region    The region id.
+         * @return          The name hash.
+         */
+        [[nodiscard]] static int landscapeNameHash(uint32_t region);
+
+    private:
+        /**
+         * The keys for specific archives, keyed by their index and archive ids.
+         */
+        std::map<std::pair<size_t, size_t>, XteaKey> archives_;
+
+        /**
+         * The keys for map regions, keyed by the name hash of their landscape archive.
+         */
+        std::map<int, XteaKey> landscapes_;
+    };
+}
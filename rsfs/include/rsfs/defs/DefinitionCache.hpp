@@ -0,0 +1,251 @@
+#pragma once
+
+#include <rsfs/io/RSBuffer.hpp>
+#include <rsfs/jag/IndexFile.hpp>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * The number of bits of a config id that select the file within an archive.
+ */
+constexpr const auto CONFIG_FILE_BITS = 8u;
+
+/**
+ * The number of locks that definition decodes are spread across.
+ */
+constexpr const auto DEFINITION_LOCK_COUNT = 64;
+
+namespace rsfs
+{
+    /**
+     * Caches the decoded definitions of a config index, such as items. Each definition is decoded once, on first
+     * use, into a contiguous table indexed by id. Lookups of decoded definitions never take a lock.
+     *
+     * When the underlying archives change, refresh() swaps in a new table that only retains the definitions of
+     * unchanged archives. References into older tables remain valid until reclaim() is called.
+     */
+    template<typename T>
+    class DefinitionCache
+    {
+    public:
+        /**
+         * The function used to decode a definition.
+         */
+        using Decoder = T (*)(RSBuffer& buf);
+
+        /**
+         * Creates a definition cache for an index.
+         * @param index     The config index that holds the definitions.
+         * @param decoder   The function used to decode a definition.
+         */
+        explicit DefinitionCache(IndexFile& index, Decoder decoder = &T::decode): index_(index), decoder_(decoder)
+        {
+            publish(std::make_unique<Generation>(index_));
+        }
+
+        /**
+         * Gets a definition, decoding it if it hasn't been decoded yet. This is safe to call from multiple threads.
+         * @param id    The definition id.
+         * @return      The definition.
+         * @throws std::out_of_range    If there is no definition with the id.
+         */
+        const T& get(size_t id)
+        {
+            auto* generation = current_.load(std::memory_order_acquire);
+            if (id >= generation->entries.size())
+                throw std::out_of_range("Definition id out of range");
+
+            if (generation->states[id].load(std::memory_order_acquire) == READY)
+                return generation->entries[id];
+            return load(*generation, id);
+        }
+
+        /**
+         * Gets the number of definition ids covered by this cache.
+         * @return  The number of ids.
+         */
+        [[nodiscard]] size_t size() const
+        {
+            return current_.load(std::memory_order_acquire)->entries.size();
+        }
+
+        /**
+         * Compares the revision and checksum of every archive with the ones the cache was built from, and drops
+         * the definitions of archives that have changed.
+         * @return  The number of archives that changed.
+         */
+        size_t refresh()
+        {
+            std::lock_guard lock(generationMutex_);
+            auto& previous = *current_.load(std::memory_order_acquire);
+            auto next      = std::make_unique<Generation>(index_);
+
+            // Carry over the definitions of archives that haven't changed
+            size_t changed = 0;
+            for (auto&& [archiveId, version]: next->versions)
+            {
+                auto it = previous.versions.find(archiveId);
+                if (it == previous.versions.end() || it->second != version)
+                {
+                    changed++;
+                    continue;
+                }
+
+                auto first = archiveId << CONFIG_FILE_BITS;
+                auto last  = std::min((archiveId + 1) << CONFIG_FILE_BITS, previous.entries.size());
+                for (auto id = first; id < last; id++)
+                {
+                    if (previous.states[id].load(std::memory_order_acquire) != READY)
+                        continue;
+                    next->entries[id] = previous.entries[id];
+                    next->states[id].store(READY, std::memory_order_relaxed);
+                }
+            }
+
+            // Archives that were removed also count as changes
+            for (auto&& [archiveId, version]: previous.versions)
+            {
+                if (!next->versions.contains(archiveId))
+                    changed++;
+            }
+
+            if (changed != 0)
+                publish(std::move(next));
+            return changed;
+        }
+
+        /**
+         * Drops every decoded definition.
+         */
+        void invalidate()
+        {
+            std::lock_guard lock(generationMutex_);
+            publish(std::make_unique<Generation>(index_));
+        }
+
+        /**
+         * Frees the tables that have been replaced by refresh() or invalidate(). The caller must ensure that no
+         * references into those tables are still in use.
+         */
+        void reclaim()
+        {
+            std::lock_guard lock(generationMutex_);
+            auto* current = current_.load(std::memory_order_acquire);
+            std::erase_if(generations_, [current](auto& generation) { return generation.get() != current; });
+        }
+
+    private:
+        /**
+         * The decode state of a definition.
+         */
+        enum State : uint8_t
+        {
+            EMPTY,
+            READY,
+        };
+
+        /**
+         * A table of definitions, built from a specific set of archive revisions.
+         */
+        struct Generation
+        {
+            /**
+             * Creates an empty table covering every archive in an index.
+             * @param index The index.
+             */
+            explicit Generation(IndexFile& index)
+            {
+                auto archiveIds = index.archiveIds();
+                auto size       = archiveIds.empty() ? 0 : (archiveIds.back() + 1) << CONFIG_FILE_BITS;
+
+                entries.resize(size);
+                states = std::make_unique<std::atomic<uint8_t>[]>(size);
+                for (auto archiveId: archiveIds)
+                {
+                    auto& data          = index.archiveData(archiveId);
+                    versions[archiveId] = { data.revision, data.crc };
+                }
+            }
+
+            /**
+             * The definitions, indexed by id.
+             */
+            std::vector<T> entries;
+
+            /**
+             * The decode state of each definition.
+             */
+            std::unique_ptr<std::atomic<uint8_t>[]> states;
+
+            /**
+             * The revision and checksum of each archive this table was built from.
+             */
+            std::map<size_t, std::pair<size_t, int>> versions;
+        };
+
+        /**
+         * Decodes a definition into a table.
+         * @param generation    The table.
+         * @param id            The definition id.
+         * @return              The definition.
+         */
+        const T& load(Generation& generation, size_t id)
+        {
+            std::lock_guard lock(locks_[id % DEFINITION_LOCK_COUNT]);
+            auto& state = generation.states[id];
+            if (state.load(std::memory_order_acquire) != READY)
+            {
+                auto data              = index_.data(id >> CONFIG_FILE_BITS, id & ((1u << CONFIG_FILE_BITS) - 1));
+                generation.entries[id] = decoder_(data);
+                state.store(READY, std::memory_order_release);
+            }
+            return generation.entries[id];
+        }
+
+        /**
+         * Makes a table the current one. The generation mutex must be held, except during construction.
+         * @param generation    The table.
+         */
+        void publish(std::unique_ptr<Generation> generation)
+        {
+            current_.store(generation.get(), std::memory_order_release);
+            generations_.push_back(std::move(generation));
+        }
+
+        /**
+         * The config index that holds the definitions.
+         */
+        IndexFile& index_;
+
+        /**
+         * The function used to decode a definition.
+         */
+        Decoder decoder_;
+
+        /**
+         * The current table.
+         */
+        std::atomic<Generation*> current_{ nullptr };
+
+        /**
+         * Every table that hasn't been reclaimed, including the current one.
+         */
+        std::vector<std::unique_ptr<Generation>> generations_;
+
+        /**
+         * The mutex guarding table swaps.
+         */
+        std::mutex generationMutex_;
+
+        /**
+         * The locks guarding definition decodes, selected by definition id.
+         */
+        std::array<std::mutex, DEFINITION_LOCK_COUNT> locks_;
+    };
+}
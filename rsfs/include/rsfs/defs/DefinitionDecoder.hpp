@@ -0,0 +1,178 @@
+#pragma once
+
+#include <rsfs/io/RSBuffer.hpp>
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * The number of possible opcodes in a definition.
+ */
+constexpr const auto OPCODE_COUNT = 256;
+
+namespace rsfs
+{
+    /**
+     * A function that decodes a single opcode into a definition.
+     */
+    template<typename T>
+    using OpcodeHandler = void (*)(T& def, RSBuffer& buf, uint8_t opcode);
+
+    /**
+     * Maps an opcode, or an inclusive range of opcodes, to the function that decodes it.
+     */
+    template<typename T>
+    struct Opcode
+    {
+        /**
+         * Maps a single opcode to a handler.
+         * @param opcode    The opcode.
+         * @param handler   The handler.
+         */
+        constexpr Opcode(uint8_t opcode, OpcodeHandler<T> handler): first(opcode), last(opcode), handler(handler)
+        {
+        }
+
+        /**
+         * Maps an inclusive range of opcodes to a handler.
+         * @param first     The first opcode in the range.
+         * @param last      The last opcode in the range.
+         * @param handler   The handler.
+         */
+        constexpr Opcode(uint8_t first, uint8_t last, OpcodeHandler<T> handler)
+            : first(first), last(last), handler(handler)
+        {
+        }
+
+        /**
+         * The first opcode in the range.
+         */
+        uint8_t first;
+
+        /**
+         * The last opcode in the range.
+         */
+        uint8_t last;
+
+        /**
+         * The handler.
+         */
+        OpcodeHandler<T> handler;
+    };
+
+    /**
+     * Declares the opcodes of a definition type. Each definition type specialises this with a static constexpr
+     * `table` of Opcode entries, and befriends the specialisation so that the handlers can write its fields.
+     * The specialisation must be visible wherever the decoder is used, which is normally the definition's
+     * source file.
+     */
+    template<typename T>
+    struct Opcodes;
+
+    /**
+     * Decodes definitions that are encoded as a stream of opcodes terminated by opcode 0. The opcode table of
+     * the definition is expanded into a jump table at compile time, so decoding an opcode costs a single
+     * indirect call, and an opcode that isn't in the table is rejected rather than desynchronising the stream.
+     */
+    template<typename T>
+    class DefinitionDecoder
+    {
+    public:
+        /**
+         * Decodes a definition from a buffer.
+         * @param buf   The buffer to read from.
+         * @return      The definition.
+         */
+        static T decode(RSBuffer& buf)
+        {
+            T def;
+            decode(def, buf);
+            return def;
+        }
+
+        /**
+         * Decodes a buffer into an existing definition.
+         * @param def   The definition to decode into.
+         * @param buf   The buffer to read from.
+         */
+        static void decode(T& def, RSBuffer& buf)
+        {
+            uint8_t opcode;
+            while ((opcode = buf.readByte()) != 0)
+            {
+                auto handler = TABLE[opcode];
+                if (!handler)
+                    throw std::runtime_error("Unknown opcode " + std::to_string(opcode));
+                handler(def, buf, opcode);
+            }
+        }
+
+    private:
+        /**
+         * Expands the opcode table of the definition into a jump table.
+         * @return  The jump table.
+         */
+        static consteval std::array<OpcodeHandler<T>, OPCODE_COUNT> build()
+        {
+            std::array<OpcodeHandler<T>, OPCODE_COUNT> table{};
+            for (auto&& entry: Opcodes<T>::table)
+            {
+                for (auto opcode = static_cast<size_t>(entry.first); opcode <= entry.last; opcode++)
+                {
+                    // Fails to compile if two entries claim the same opcode
+                    if (table[opcode] != nullptr)
+                        throw std::logic_error("Duplicate opcode");
+                    table[opcode] = entry.handler;
+                }
+            }
+            return table;
+        }
+
+        /**
+         * The jump table, indexed by opcode.
+         */
+        static constexpr std::array<OpcodeHandler<T>, OPCODE_COUNT> TABLE = build();
+    };
+
+    /**
+     * A handler that skips a fixed number of bytes, for opcodes whose values aren't exposed.
+     */
+    template<typename T, size_t Bytes>
+    void skip(T&, RSBuffer& buf, uint8_t)
+    {
+        for (size_t i = 0; i < Bytes; i++)
+            (void) buf.readByte();
+    }
+
+    /**
+     * A handler that skips a length-prefixed list of fixed size values.
+     */
+    template<typename T, size_t Bytes>
+    void skipList(T&, RSBuffer& buf, uint8_t)
+    {
+        auto count = buf.readByte();
+        for (size_t i = 0; i < count * Bytes; i++)
+            (void) buf.readByte();
+    }
+
+    /**
+     * A handler that skips a parameter map, which is shared by most definition types. Each parameter is keyed
+     * by a three-byte id, and holds either a string or an integer.
+     */
+    template<typename T>
+    void skipParams(T&, RSBuffer& buf, uint8_t)
+    {
+        auto count = buf.readByte();
+        for (auto i = 0; i < count; i++)
+        {
+            auto isString = buf.readByte() == 1;
+            (void) buf.readTriByte();
+            if (isString)
+                (void) buf.readString();
+            else
+                (void) buf.readInt();
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <rsfs/RSFileSystem.hpp>
+#include <rsfs/defs/DefinitionDecoder.hpp>
 #include <rsfs/io/RSBuffer.hpp>
 
 #include <vector>
@@ -30,6 +31,7 @@ namespace rsfs
          * Decodes an item definition from a buffer.
          * @param buf   The buffer to read from.
          * @return      The item. definition.
+         * @throws std::runtime_error   If the buffer contains an unknown opcode.
          */
         static ItemDefinition decode(RSBuffer& buf);
 
@@ -42,7 +44,171 @@ namespace rsfs
             return name_;
         }
 
+        /**
+         * Gets the model id of this item.
+         * @return  The model id.
+         */
+        [[nodiscard]] size_t model() const
+        {
+            return model_;
+        }
+
+        /**
+         * Checks if this item is members-only.
+         * @return  If the item is members-only.
+         */
+        [[nodiscard]] bool members() const
+        {
+            return members_;
+        }
+
+        /**
+         * Gets the right-click inventory options for this item.
+         * @return  The inventory options.
+         */
+        [[nodiscard]] const std::array<std::string, NUM_OPTIONS>& options() const
+        {
+            return options_;
+        }
+
+        /**
+         * Gets the right-click ground options for this item.
+         * @return  The ground options.
+         */
+        [[nodiscard]] const std::array<std::string, NUM_OPTIONS>& groundOptions() const
+        {
+            return groundOptions_;
+        }
+
+        /**
+         * Gets the shop value of this item.
+         * @return  The value.
+         */
+        [[nodiscard]] size_t value() const
+        {
+            return value_;
+        }
+
+        /**
+         * Checks if this item is stackable.
+         * @return  If the item is stackable.
+         */
+        [[nodiscard]] bool stackable() const
+        {
+            return stackable_;
+        }
+
+        /**
+         * Gets the stack size of this item.
+         * @return  The stack size.
+         */
+        [[nodiscard]] size_t stackSize() const
+        {
+            return stackSize_;
+        }
+
+        /**
+         * Gets the primary male model id.
+         * @return  The model id.
+         */
+        [[nodiscard]] size_t primaryMaleModel() const
+        {
+            return primaryMaleModel_;
+        }
+
+        /**
+         * Gets the secondary male model id.
+         * @return  The model id.
+         */
+        [[nodiscard]] size_t secondaryMaleModel() const
+        {
+            return secondaryMaleModel_;
+        }
+
+        /**
+         * Gets the primary female model id.
+         * @return  The model id.
+         */
+        [[nodiscard]] size_t primaryFemaleModel() const
+        {
+            return primaryFemaleModel_;
+        }
+
+        /**
+         * Gets the secondary female model id.
+         * @return  The model id.
+         */
+        [[nodiscard]] size_t secondaryFemaleModel() const
+        {
+            return secondaryFemaleModel_;
+        }
+
+        /**
+         * Gets the scale of the inventory sprite.
+         * @return  The scale.
+         */
+        [[nodiscard]] size_t spriteScale() const
+        {
+            return spriteScale_;
+        }
+
+        /**
+         * Gets the rotation of the inventory sprite around the x-axis.
+         * @return  The rotation.
+         */
+        [[nodiscard]] size_t spritePitch() const
+        {
+            return spritePitch_;
+        }
+
+        /**
+         * Gets the rotation of the inventory sprite around the y-axis.
+         * @return  The rotation.
+         */
+        [[nodiscard]] size_t spriteCameraRoll() const
+        {
+            return spriteCameraRoll_;
+        }
+
+        /**
+         * Gets the x translation of the inventory sprite.
+         * @return  The translation.
+         */
+        [[nodiscard]] size_t spriteTranslateX() const
+        {
+            return spriteTranslateX_;
+        }
+
+        /**
+         * Gets the y translation of the inventory sprite.
+         * @return  The translation.
+         */
+        [[nodiscard]] size_t spriteTranslateY() const
+        {
+            return spriteTranslateY_;
+        }
+
+        /**
+         * Gets the colour modification pairs of this item, in the format of (old, new).
+         * @return  The colour modifications.
+         */
+        [[nodiscard]] const std::vector<std::pair<size_t, size_t>>& colourModifications() const
+        {
+            return colourModifications_;
+        }
+
+        /**
+         * Gets the texture modification pairs of this item, in the format of (old, new).
+         * @return  The texture modifications.
+         */
+        [[nodiscard]] const std::vector<std::pair<size_t, size_t>>& textureModifications() const
+        {
+            return textureModifications_;
+        }
+
     private:
+        friend struct Opcodes<ItemDefinition>;
+
         /**
          * The model id of this item.
          */
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <rsfs/defs/ItemTable.hpp>
+#include <rsfs/jag/IndexFile.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace rsfs
+{
+    /**
+     * A read-only view of an item table that has been written to a snapshot file. The file is memory mapped
+     * rather than read, so opening it is almost free, and processes on the same host that open the same
+     * snapshot share its pages.
+     *
+     * The snapshot holds the same columns as an ItemTable, at offsets relative to the start of the file, along
+     * with the checksum and revision of every item archive that it was built from.
+     */
+    class ItemSnapshot
+    {
+    public:
+        /**
+         * Writes an item table to a snapshot file.
+         * @param table The item table.
+         * @param items The item index that the table was loaded from.
+         * @param path  The path to write the snapshot to.
+         */
+        static void write(const ItemTable& table, const IndexFile& items, const std::string& path);
+
+        /**
+         * Maps a snapshot file.
+         * @param path  The path to the snapshot.
+         * @throws std::runtime_error   If the file isn't a snapshot, was written by an incompatible version, or is
+         *                              corrupt.
+         */
+        explicit ItemSnapshot(const std::string& path);
+
+        /**
+         * Checks if this snapshot was built from the current revision of every item archive.
+         * @param items The item index.
+         * @return      If the snapshot is up to date.
+         */
+        [[nodiscard]] bool matches(const IndexFile& items) const;
+
+        /**
+         * Gets the number of item ids covered by this snapshot.
+         * @return  The number of ids.
+         */
+        [[nodiscard]] size_t size() const
+        {
+            return flags_.size();
+        }
+
+        /**
+         * Checks if this snapshot contains an item with a specified id.
+         * @param id    The item id.
+         * @return      If the item exists.
+         */
+        [[nodiscard]] bool contains(size_t id) const
+        {
+            return id < flags_.size() && (flags_[id] & ItemTable::FLAG_PRESENT) != 0;
+        }
+
+        /**
+         * Gets the name of an item.
+         * @param id    The item id.
+         * @return      The name.
+         */
+        [[nodiscard]] std::string_view name(size_t id) const
+        {
+            return string(name_[checked(id)]);
+        }
+
+        /**
+         * Gets the model id of an item.
+         * @param id    The item id.
+         * @return      The model id.
+         */
+        [[nodiscard]] uint16_t model(size_t id) const
+        {
+            return model_[checked(id)];
+        }
+
+        /**
+         * Checks if an item is members-only.
+         * @param id    The item id.
+         * @return      If the item is members-only.
+         */
+        [[nodiscard]] bool members(size_t id) const
+        {
+            return (flags_[checked(id)] & ItemTable::FLAG_MEMBERS) != 0;
+        }
+
+        /**
+         * Checks if an item is stackable.
+         * @param id    The item id.
+         * @return      If the item is stackable.
+         */
+        [[nodiscard]] bool stackable(size_t id) const
+        {
+            return (flags_[checked(id)] & ItemTable::FLAG_STACKABLE) != 0;
+        }
+
+        /**
+         * Gets a right-click inventory option of an item.
+         * @param id    The item id.
+         * @param slot  The option slot.
+         * @return      The option.
+         */
+        [[nodiscard]] std::string_view option(size_t id, size_t slot) const
+        {
+            return string(optionSets_[options_[checked(id)]].at(slot));
+        }
+
+        /**
+         * Gets a right-click ground option of an item.
+         * @param id    The item id.
+         * @param slot  The option slot.
+         * @return      The option.
+         */
+        [[nodiscard]] std::string_view groundOption(size_t id, size_t slot) const
+        {
+            return string(optionSets_[groundOptions_[checked(id)]].at(slot));
+        }
+
+        /**
+         * Gets the shop value of an item.
+         * @param id    The item id.
+         * @return      The value.
+         */
+        [[nodiscard]] int32_t value(size_t id) const
+        {
+            return value_[checked(id)];
+        }
+
+        /**
+         * Gets the stack size of an item.
+         * @param id    The item id.
+         * @return      The stack size.
+         */
+        [[nodiscard]] uint16_t stackSize(size_t id) const
+        {
+            return stackSize_[checked(id)];
+        }
+
+        /**
+         * Gets one of the worn model ids of an item, in the order primary male, secondary male, primary female
+         * and secondary female.
+         * @param id    The item id.
+         * @param slot  The model slot.
+         * @return      The model id.
+         */
+        [[nodiscard]] uint16_t wornModel(size_t id, size_t slot) const
+        {
+            return wornModels_[checked(id)].at(slot);
+        }
+
+        /**
+         * Gets one of the inventory sprite properties of an item, in the order scale, pitch, camera roll,
+         * x translation and y translation.
+         * @param id    The item id.
+         * @param slot  The property slot.
+         * @return      The property value.
+         */
+        [[nodiscard]] uint16_t sprite(size_t id, size_t slot) const
+        {
+            return sprite_[checked(id)].at(slot);
+        }
+
+        /**
+         * Gets the colour modification pairs of an item, in the format of (old, new).
+         * @param id    The item id.
+         * @return      The colour modifications.
+         */
+        [[nodiscard]] std::span<const std::pair<uint16_t, uint16_t>> colourModifications(size_t id) const
+        {
+            auto range = colours_[checked(id)];
+            return modifications_.subspan(range.offset, range.length);
+        }
+
+        /**
+         * Gets the texture modification pairs of an item, in the format of (old, new).
+         * @param id    The item id.
+         * @return      The texture modifications.
+         */
+        [[nodiscard]] std::span<const std::pair<uint16_t, uint16_t>> textureModifications(size_t id) const
+        {
+            auto range = textures_[checked(id)];
+            return modifications_.subspan(range.offset, range.length);
+        }
+
+    private:
+        /**
+         * The version of an archive that the snapshot was built from.
+         */
+        struct ArchiveVersion
+        {
+            /**
+             * The archive id.
+             */
+            uint32_t id;
+
+            /**
+             * The checksum of the archive.
+             */
+            int32_t crc;
+
+            /**
+             * The revision of the archive.
+             */
+            uint32_t revision;
+
+            /**
+             * Padding, to keep the records aligned.
+             */
+            uint32_t reserved;
+        };
+
+        /**
+         * Validates an item id.
+         * @param id    The item id.
+         * @return      The item id.
+         * @throws std::out_of_range    If the id is out of range.
+         */
+        [[nodiscard]] size_t checked(size_t id) const
+        {
+            if (id >= flags_.size())
+                throw std::out_of_range("Item id out of range");
+            return id;
+        }
+
+        /**
+         * Gets an interned string.
+         * @param id    The string id.
+         * @return      The string.
+         */
+        [[nodiscard]] std::string_view string(uint32_t id) const
+        {
+            auto begin = stringOffsets_[id];
+            return { stringData_.data() + begin, stringOffsets_[id + 1] - begin };
+        }
+
+        /**
+         * Gets a section of the mapped file.
+         * @param offset    The offset of the section.
+         * @param count     The number of elements in the section.
+         * @return          The section.
+         */
+        template<typename T>
+        std::span<const T> section(uint64_t offset, uint64_t count) const;
+
+        /**
+         * The mapped snapshot file.
+         */
+        boost::iostreams::mapped_file_source file_;
+
+        /**
+         * The versions of the archives that the snapshot was built from.
+         */
+        std::span<const ArchiveVersion> archives_;
+
+        /**
+         * The columns of the snapshot. See ItemTable for their meaning.
+         */
+        std::span<const uint8_t> flags_;
+        std::span<const uint16_t> model_;
+        std::span<const uint32_t> name_;
+        std::span<const uint32_t> options_;
+        std::span<const uint32_t> groundOptions_;
+        std::span<const int32_t> value_;
+        std::span<const uint16_t> stackSize_;
+        std::span<const std::array<uint16_t, 4>> wornModels_;
+        std::span<const std::array<uint16_t, 5>> sprite_;
+        std::span<const ItemTable::Range> colours_;
+        std::span<const ItemTable::Range> textures_;
+        std::span<const std::pair<uint16_t, uint16_t>> modifications_;
+        std::span<const std::array<uint32_t, NUM_OPTIONS>> optionSets_;
+        std::span<const uint32_t> stringOffsets_;
+        std::span<const char> stringData_;
+    };
+}
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <rsfs/RSFileSystem.hpp>
+#include <rsfs/defs/ItemDefinition.hpp>
+
+#include <array>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rsfs
+{
+    /**
+     * A compact, column-oriented table of every item definition in the filesystem. Each property is stored in
+     * its own array indexed by item id, strings and option sets are interned, and boolean properties are
+     * packed into a single flags byte.
+     */
+    class ItemTable
+    {
+    public:
+        /**
+         * A range of entries in the shared modification array.
+         */
+        struct Range
+        {
+            /**
+             * The offset of the first entry.
+             */
+            uint32_t offset{ 0 };
+
+            /**
+             * The number of entries.
+             */
+            uint32_t length{ 0 };
+        };
+
+        /**
+         * Decodes every item definition in the filesystem, decoding one archive per task on a thread pool.
+         * @param fs        The filesystem to read from.
+         * @param threads   The number of worker threads, or 0 to use the number of hardware threads.
+         * @return          The item table.
+         */
+        static ItemTable load(RSFileSystem& fs, size_t threads = 0);
+
+        /**
+         * Adds an item definition to this table.
+         * @param id    The item id.
+         * @param def   The item definition.
+         */
+        void add(size_t id, const ItemDefinition& def);
+
+        /**
+         * Gets the number of item ids covered by this table. This is one greater than the highest item id.
+         * @return  The number of ids.
+         */
+        [[nodiscard]] size_t size() const
+        {
+            return flags_.size();
+        }
+
+        /**
+         * Checks if this table contains an item with a specified id.
+         * @param id    The item id.
+         * @return      If the item exists.
+         */
+        [[nodiscard]] bool contains(size_t id) const
+        {
+            return id < flags_.size() && (flags_[id] & FLAG_PRESENT) != 0;
+        }
+
+        /**
+         * Gets the name of an item.
+         * @param id    The item id.
+         * @return      The name.
+         */
+        [[nodiscard]] std::string_view name(size_t id) const
+        {
+            return strings_.at(name_.at(id));
+        }
+
+        /**
+         * Gets the model id of an item.
+         * @param id    The item id.
+         * @return      The model id.
+         */
+        [[nodiscard]] uint16_t model(size_t id) const
+        {
+            return model_.at(id);
+        }
+
+        /**
+         * Checks if an item is members-only.
+         * @param id    The item id.
+         * @return      If the item is members-only.
+         */
+        [[nodiscard]] bool members(size_t id) const
+        {
+            return (flags_.at(id) & FLAG_MEMBERS) != 0;
+        }
+
+        /**
+         * Checks if an item is stackable.
+         * @param id    The item id.
+         * @return      If the item is stackable.
+         */
+        [[nodiscard]] bool stackable(size_t id) const
+        {
+            return (flags_.at(id) & FLAG_STACKABLE) != 0;
+        }
+
+        /**
+         * Gets a right-click inventory option of an item.
+         * @param id    The item id.
+         * @param slot  The option slot.
+         * @return      The option.
+         */
+        [[nodiscard]] std::string_view option(size_t id, size_t slot) const
+        {
+            return strings_.at(optionSets_.at(options_.at(id)).at(slot));
+        }
+
+        /**
+         * Gets a right-click ground option of an item.
+         * @param id    The item id.
+         * @param slot  The option slot.
+         * @return      The option.
+         */
+        [[nodiscard]] std::string_view groundOption(size_t id, size_t slot) const
+        {
+            return strings_.at(optionSets_.at(groundOptions_.at(id)).at(slot));
+        }
+
+        /**
+         * Gets the shop value of an item.
+         * @param id    The item id.
+         * @return      The value.
+         */
+        [[nodiscard]] int32_t value(size_t id) const
+        {
+            return value_.at(id);
+        }
+
+        /**
+         * Gets the stack size of an item.
+         * @param id    The item id.
+         * @return      The stack size.
+         */
+        [[nodiscard]] uint16_t stackSize(size_t id) const
+        {
+            return stackSize_.at(id);
+        }
+
+        /**
+         * Gets one of the worn model ids of an item, in the order primary male, secondary male, primary female
+         * and secondary female.
+         * @param id    The item id.
+         * @param slot  The model slot.
+         * @return      The model id.
+         */
+        [[nodiscard]] uint16_t wornModel(size_t id, size_t slot) const
+        {
+            return wornModels_.at(id).at(slot);
+        }
+
+        /**
+         * Gets one of the inventory sprite properties of an item, in the order scale, pitch, camera roll,
+         * x translation and y translation.
+         * @param id    The item id.
+         * @param slot  The property slot.
+         * @return      The property value.
+         */
+        [[nodiscard]] uint16_t sprite(size_t id, size_t slot) const
+        {
+            return sprite_.at(id).at(slot);
+        }
+
+        /**
+         * Gets the colour modification pairs of an item, in the format of (old, new).
+         * @param id    The item id.
+         * @return      The colour modifications.
+         */
+        [[nodiscard]] std::span<const std::pair<uint16_t, uint16_t>> colourModifications(size_t id) const
+        {
+            auto range = colours_.at(id);
+            return std::span(modifications_).subspan(range.offset, range.length);
+        }
+
+        /**
+         * Gets the texture modification pairs of an item, in the format of (old, new).
+         * @param id    The item id.
+         * @return      The texture modifications.
+         */
+        [[nodiscard]] std::span<const std::pair<uint16_t, uint16_t>> textureModifications(size_t id) const
+        {
+            auto range = textures_.at(id);
+            return std::span(modifications_).subspan(range.offset, range.length);
+        }
+
+        /**
+         * Gets the approximate number of bytes used by this table.
+         * @return  The memory usage, in bytes.
+         */
+        [[nodiscard]] size_t memoryUsage() const;
+
+    private:
+        friend class ItemSnapshot;
+
+        /**
+         * The flags packed into the flags column.
+         */
+        static constexpr uint8_t FLAG_PRESENT   = 0x1u;
+        static constexpr uint8_t FLAG_MEMBERS   = 0x2u;
+        static constexpr uint8_t FLAG_STACKABLE = 0x4u;
+
+        /**
+         * Ensures that the columns can hold a specified item id.
+         * @param id    The item id.
+         */
+        void reserve(size_t id);
+
+        /**
+         * Interns a string.
+         * @param value The string.
+         * @return      The id of the interned string.
+         */
+        uint32_t intern(const std::string& value);
+
+        /**
+         * Interns a set of options.
+         * @param options   The options.
+         * @return          The id of the interned option set.
+         */
+        uint32_t intern(const std::array<std::string, NUM_OPTIONS>& options);
+
+        /**
+         * Appends a list of modifications to the shared modification array.
+         * @param modifications The modifications.
+         * @return              The range of the appended modifications.
+         */
+        Range append(const std::vector<std::pair<size_t, size_t>>& modifications);
+
+        /**
+         * The packed flags of each item.
+         */
+        std::vector<uint8_t> flags_;
+
+        /**
+         * The model id of each item.
+         */
+        std::vector<uint16_t> model_;
+
+        /**
+         * The interned name of each item.
+         */
+        std::vector<uint32_t> name_;
+
+        /**
+         * The interned inventory option set of each item.
+         */
+        std::vector<uint32_t> options_;
+
+        /**
+         * The interned ground option set of each item.
+         */
+        std::vector<uint32_t> groundOptions_;
+
+        /**
+         * The shop value of each item.
+         */
+        std::vector<int32_t> value_;
+
+        /**
+         * The stack size of each item.
+         */
+        std::vector<uint16_t> stackSize_;
+
+        /**
+         * The worn model ids of each item.
+         */
+        std::vector<std::array<uint16_t, 4>> wornModels_;
+
+        /**
+         * The inventory sprite properties of each item.
+         */
+        std::vector<std::array<uint16_t, 5>> sprite_;
+
+        /**
+         * The range of colour modifications of each item.
+         */
+        std::vector<Range> colours_;
+
+        /**
+         * The range of texture modifications of each item.
+         */
+        std::vector<Range> textures_;
+
+        /**
+         * The modification pairs of every item.
+         */
+        std::vector<std::pair<uint16_t, uint16_t>> modifications_;
+
+        /**
+         * The interned strings. The first string is always empty.
+         */
+        std::vector<std::string> strings_{ "" };
+
+        /**
+         * The interned option sets, as interned string ids.
+         */
+        std::vector<std::array<uint32_t, NUM_OPTIONS>> optionSets_;
+
+        /**
+         * A map of strings to their interned id.
+         */
+        std::unordered_map<std::string, uint32_t> stringIds_{ { "", 0 } };
+
+        /**
+         * A map of option sets to their interned id.
+         */
+        std::map<std::array<uint32_t, NUM_OPTIONS>, uint32_t> optionSetIds_;
+    };
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <rsfs/RSFileSystem.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rsfs
+{
+    /**
+     * Represents how an index, archive or file differs between two caches.
+     */
+    enum ChangeType : uint8_t
+    {
+        ADDED,
+        REMOVED,
+        CHANGED,
+    };
+
+    /**
+     * A file that differs between two caches.
+     */
+    struct FileChange
+    {
+        /**
+         * The id of the file.
+         */
+        size_t id{ 0 };
+
+        /**
+         * How the file differs.
+         */
+        ChangeType type{ CHANGED };
+    };
+
+    /**
+     * An archive that differs between two caches.
+     */
+    struct ArchiveChange
+    {
+        /**
+         * The id of the archive.
+         */
+        size_t id{ 0 };
+
+        /**
+         * How the archive differs.
+         */
+        ChangeType type{ CHANGED };
+
+        /**
+         * The revision of the archive in the old cache, or 0 if it was added.
+         */
+        size_t oldRevision{ 0 };
+
+        /**
+         * The revision of the archive in the new cache, or 0 if it was removed.
+         */
+        size_t newRevision{ 0 };
+
+        /**
+         * The files that differ, if the archive changed and its contents were compared.
+         */
+        std::vector<FileChange> files;
+
+        /**
+         * If the archive couldn't be decompressed, such as an encrypted archive without its key, and its compressed
+         * containers differ. The files that changed are unknown.
+         */
+        bool compressedOnly{ false };
+
+        /**
+         * If the name hash of the archive differs.
+         */
+        bool renamed{ false };
+    };
+
+    /**
+     * An index that differs between two caches.
+     */
+    struct IndexChange
+    {
+        /**
+         * The id of the index.
+         */
+        size_t id{ 0 };
+
+        /**
+         * How the index differs.
+         */
+        ChangeType type{ CHANGED };
+
+        /**
+         * The revision of the index in the old cache, or 0 if it was added.
+         */
+        size_t oldRevision{ 0 };
+
+        /**
+         * The revision of the index in the new cache, or 0 if it was removed.
+         */
+        size_t newRevision{ 0 };
+
+        /**
+         * The archives that differ, in ascending id order.
+         */
+        std::vector<ArchiveChange> archives;
+    };
+
+    /**
+     * The options used when comparing two caches.
+     */
+    struct DiffOptions
+    {
+        /**
+         * The number of worker threads, or 0 to use the number of hardware threads.
+         */
+        size_t threads{ 0 };
+
+        /**
+         * If the contents of archives whose metadata differs should be compared, to find the files that changed.
+         * Archives whose contents turn out to be identical, such as ones that were only recompressed, are then
+         * left out of the diff.
+         */
+        bool compareContents{ true };
+    };
+
+    /**
+     * The differences between two caches. Archives are compared using the checksums, revisions and file ids in the
+     * reference tables, and their contents are only read when that metadata shows they may have changed.
+     */
+    class CacheDiff
+    {
+    public:
+        /**
+         * Compares two caches.
+         * @param from      The old cache.
+         * @param to        The new cache.
+         * @param options   The options to compare the caches with.
+         * @return          The differences.
+         */
+        static CacheDiff compare(RSFileSystem& from, RSFileSystem& to, DiffOptions options = {});
+
+        /**
+         * Gets the indices that differ, in ascending id order.
+         * @return  The changed indices.
+         */
+        [[nodiscard]] const std::vector<IndexChange>& indices() const
+        {
+            return indices_;
+        }
+
+        /**
+         * Checks if the two caches are identical.
+         * @return  If there are no differences.
+         */
+        [[nodiscard]] bool empty() const
+        {
+            return indices_.empty();
+        }
+
+    private:
+        /**
+         * The indices that differ.
+         */
+        std::vector<IndexChange> indices_;
+    };
+}
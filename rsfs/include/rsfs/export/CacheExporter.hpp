@@ -0,0 +1,128 @@
+#pragma once
+
+#include <rsfs/RSFileSystem.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rsfs
+{
+    /**
+     * Represents the layout an exported cache is written in.
+     */
+    enum ExportFormat : uint8_t
+    {
+        /**
+         * Each file is written to "<index>/<archive>/<file>", with a "manifest.tsv" in each index directory
+         * listing the archive and file name hashes.
+         */
+        DIRECTORY,
+
+        /**
+         * Every file is written to a single packed file, followed by a table of PackRecords.
+         */
+        PACKED,
+    };
+
+    /**
+     * The options used when exporting a cache.
+     */
+    struct ExportOptions
+    {
+        /**
+         * The layout to write the cache in.
+         */
+        ExportFormat format{ DIRECTORY };
+
+        /**
+         * The number of worker threads, or 0 to use the number of hardware threads. At most one archive per worker
+         * is held in memory at a time.
+         */
+        size_t threads{ 0 };
+
+        /**
+         * The indices to export, or empty to export every index.
+         */
+        std::vector<size_t> indices;
+
+        /**
+         * If archives that can't be read, such as encrypted archives without a key, should be skipped rather than
+         * failing the export.
+         */
+        bool skipErrors{ false };
+    };
+
+    /**
+     * The totals of an export.
+     */
+    struct ExportStats
+    {
+        /**
+         * The number of archives exported.
+         */
+        size_t archives{ 0 };
+
+        /**
+         * The number of files exported.
+         */
+        size_t files{ 0 };
+
+        /**
+         * The number of bytes of file data exported.
+         */
+        size_t bytes{ 0 };
+
+        /**
+         * The number of archives that were skipped because they couldn't be read.
+         */
+        size_t failures{ 0 };
+    };
+
+    /**
+     * The header at the start of a packed export, in native byte order.
+     */
+    struct PackHeader
+    {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t recordCount;
+        uint64_t recordOffset;
+    };
+
+    /**
+     * The location of a file in a packed export. The records are written in ascending index, archive and file
+     * order.
+     */
+    struct PackRecord
+    {
+        uint32_t index;
+        uint32_t archive;
+        uint32_t file;
+        int32_t archiveNameHash;
+        int32_t fileNameHash;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    /**
+     * Exports the files of every archive in a cache. Archives are read, decompressed and split on a thread pool,
+     * and each worker writes its files out as soon as they are split, so memory use is bounded by the number of
+     * workers rather than the size of the cache.
+     */
+    class CacheExporter
+    {
+    public:
+        /**
+         * Exports a cache.
+         * @param fs        The filesystem to export.
+         * @param path      The directory or packed file to write to.
+         * @param options   The options to export the cache with.
+         * @return          The totals of the export.
+         */
+        static ExportStats write(RSFileSystem& fs, const std::string& path, ExportOptions options = {});
+    };
+}
@@ -1,14 +1,21 @@
 #pragma once
+#include <boost/container/small_vector.hpp>
 #include <boost/range/iterator_range.hpp>
 
 #include <fstream>
 #include <sstream>
 #include <vector>
 
+/**
+ * The number of bytes a buffer stores inline before it allocates, which keeps a buffer to a single cache line.
+ */
+constexpr const auto INLINE_BUFFER_SIZE = 32;
+
 namespace rsfs
 {
     /**
-     * A RuneScape specific byte buffer implementation.
+     * A RuneScape specific byte buffer implementation. Small buffers, such as most config files, are stored inline
+     * without allocating.
      */
     class RSBuffer
     {
@@ -20,10 +27,15 @@ namespace rsfs
         explicit RSBuffer(std::ifstream& stream);
 
         /**
-         * Initialises an empty buffer with a fixed size.
-         * @param size  The desired size of the buffer.
+         * Initialises an empty buffer.
          */
-        explicit RSBuffer(size_t size = 512);
+        RSBuffer() = default;
+
+        /**
+         * Initialises an empty buffer with room for a number of bytes.
+         * @param size  The number of bytes to reserve.
+         */
+        explicit RSBuffer(size_t size);
 
         /**
          * Initialises a buffer from an array.
@@ -69,12 +81,24 @@ namespace rsfs
          */
         void writeBytes(boost::iterator_range<const char*> range);
 
+        /**
+         * Writes a two-byte integer to the buffer.
+         * @param value The value to write.
+         */
+        void writeShort(uint16_t value);
+
         /**
          * Writes an integer to the buffer.
          * @param value The value to write.
          */
         void writeInt(int32_t value);
 
+        /**
+         * Writes a value as a short if it fits in 15 bits, or otherwise as an integer with the top bit set.
+         * @param value The value to write.
+         */
+        void writeSmart(uint32_t value);
+
         /**
          * Gets the value at the current offset, but doesn't advance the reader.
          * @return  The current byte value
@@ -149,7 +173,16 @@ namespace rsfs
          */
         [[nodiscard]] const char* begin() const
         {
-            return buf_.begin().base();
+            return buf_.data();
+        }
+
+        /**
+         * Gets a mutable pointer to the beginning of the buffer, used to transform its contents in place.
+         * @return  The beginning of the buffer.
+         */
+        [[nodiscard]] char* data()
+        {
+            return buf_.data();
         }
 
         /**
@@ -158,7 +191,7 @@ namespace rsfs
          */
         [[nodiscard]] const char* end() const
         {
-            return buf_.end().base();
+            return buf_.data() + buf_.size();
         }
 
         /**
@@ -174,7 +207,7 @@ namespace rsfs
         /**
          * The internal buffer
          */
-        std::vector<char> buf_;
+        boost::container::small_vector<char, INLINE_BUFFER_SIZE> buf_;
 
         /**
          * The index of the reader
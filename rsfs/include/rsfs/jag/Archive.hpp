@@ -1,9 +1,15 @@
 #pragma once
 #include <rsfs/io/RSBuffer.hpp>
 #include <rsfs/jag/ArchiveData.hpp>
+#include <rsfs/jag/Extraction.hpp>
 #include <rsfs/jag/FileData.hpp>
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <span>
 #include <vector>
 
 namespace rsfs
@@ -17,14 +23,28 @@ namespace rsfs
         /**
          * Initialises this archive based on it's metadata.
          * @param data  The archive's metadata.
+         * @param arena The resource that the metadata was allocated from, if any, which is kept alive for as long
+         *              as this archive.
          */
-        explicit Archive(ArchiveData data);
+        explicit Archive(ArchiveData data, std::shared_ptr<std::pmr::memory_resource> arena = nullptr);
 
         /**
-         * Reads the data for an archive.
-         * @param buf   The decompressed archive data.
+         * Initialises an archive that replaces an unchanged archive from an older reference table. The contents of
+         * the previous archive are shared if it has been loaded, but its metadata and arena are not kept alive.
+         * @param data      The archive's metadata.
+         * @param arena     The resource that the metadata was allocated from, if any.
+         * @param previous  The archive being replaced.
          */
-        void read(RSBuffer& buf);
+        Archive(ArchiveData data, std::shared_ptr<std::pmr::memory_resource> arena, const Archive& previous);
+
+        /**
+         * Reads the data for an archive. The archive is only marked as loaded once all of its files are available.
+         * The archive takes ownership of the buffer, which the files refer to in place unless they have to be
+         * reassembled from several chunks.
+         * @param buf           The decompressed archive data.
+         * @param extraction    When the files in the archive should be extracted.
+         */
+        void read(RSBuffer buf, Extraction extraction = EAGER);
 
         /**
          * Gets a sorted vector of all the files in this archive.
@@ -39,13 +59,21 @@ namespace rsfs
          */
         [[nodiscard]] RSBuffer getFileData(size_t id) const;
 
+        /**
+         * Gets the contents of a specific file, extracting it if it hasn't been extracted yet. This is safe to
+         * call from multiple threads.
+         * @param id    The file id.
+         * @return      The file contents, which remain valid for the lifetime of the archive.
+         */
+        [[nodiscard]] std::span<const char> file(size_t id) const;
+
         /**
          * Checks if this archive has been loaded.
          * @return  If the archive has been loaded.
          */
         [[nodiscard]] bool loaded() const
         {
-            return loaded_;
+            return loaded_.load(std::memory_order_acquire);
         }
 
         /**
@@ -93,7 +121,22 @@ namespace rsfs
             return data_.whirlpool;
         }
 
+        /**
+         * Gets the metadata of this archive.
+         * @return  The archive metadata.
+         */
+        [[nodiscard]] const ArchiveData& metadata() const
+        {
+            return data_;
+        }
+
     private:
+        /**
+         * The resource that the metadata was allocated from. This is declared first so that it outlives the
+         * metadata.
+         */
+        std::shared_ptr<std::pmr::memory_resource> arena_;
+
         /**
          * The archive meta data.
          */
@@ -102,11 +145,67 @@ namespace rsfs
         /**
          * If this archive has been loaded.
          */
-        bool loaded_{ false };
+        std::atomic<bool> loaded_{ false };
+
+        /**
+         * Gets the position of a file in the metadata.
+         * @param id    The file id.
+         * @return      The position of the file.
+         */
+        [[nodiscard]] size_t position(size_t id) const;
+
+        /**
+         * The data of a loaded archive. This is shared with the archives that replace this one when an unchanged
+         * archive is carried over to a newer reference table.
+         */
+        struct Contents
+        {
+            /**
+             * The contents of every file in the archive, stored back to back in file id order. When the archive has
+             * a single file, or its files are extracted on demand, this is instead the decompressed archive data,
+             * truncated before the chunk table.
+             */
+            RSBuffer block;
+
+            /**
+             * The contents of each file that refers to its contents in place, in the same order as the metadata.
+             */
+            std::vector<std::span<const char>> files;
+
+            /**
+             * The number of chunks in the archive, if its files are extracted on demand.
+             */
+            size_t chunks{ 0 };
+
+            /**
+             * The offsets of each file's chunks in the block, in chunk table order, if the files are extracted on
+             * demand. The final offset is the end of the last chunk.
+             */
+            std::vector<size_t> chunkOffsets;
+
+            /**
+             * The mutex guarding the extraction of files split across several chunks.
+             */
+            std::mutex extractMutex;
+
+            /**
+             * The contents of files split across several chunks that have been extracted, keyed by file id.
+             */
+            std::map<size_t, std::vector<char>> extracted;
+        };
+
+        /**
+         * Parses the chunk table of an archive, leaving its files to be extracted when they are requested.
+         * @param buf           The decompressed archive data, which is moved into the contents.
+         * @param chunks        The number of chunks.
+         * @param tableOffset   The offset of the chunk table.
+         * @param contents      The contents to map the chunks into.
+         */
+        void mapChunks(RSBuffer& buf, size_t chunks, size_t tableOffset, Contents& contents);
 
         /**
-         * A map of file ids to the file data.
+         * The data of this archive, which is only set once it has been loaded.
          */
-        std::map<size_t, FileData> files_;
+        std::shared_ptr<Contents> contents_;
     };
 }
\ No newline at end of file
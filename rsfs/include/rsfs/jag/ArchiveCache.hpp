@@ -0,0 +1,99 @@
+#pragma once
+
+#include <rsfs/jag/Archive.hpp>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace rsfs
+{
+    /**
+     * A small cache of recently used, decompressed archives, shared by every index of a filesystem. When it is
+     * full, the least recently used archive is evicted. Evicted archives remain valid for as long as a caller
+     * holds a reference to them.
+     */
+    class ArchiveCache
+    {
+    public:
+        /**
+         * Creates an archive cache.
+         * @param capacity  The maximum number of archives to keep.
+         */
+        explicit ArchiveCache(size_t capacity);
+
+        /**
+         * Gets an archive from the cache, if its checksum and revision match the metadata it is expected to have.
+         * This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param metadata  The current metadata of the archive.
+         * @return          The archive, or null if it isn't cached or is out of date.
+         */
+        std::shared_ptr<const Archive> get(size_t index, const ArchiveData& metadata);
+
+        /**
+         * Adds an archive to the cache, evicting the least recently used archive if the cache is full. This is
+         * safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive.
+         */
+        void put(size_t index, std::shared_ptr<const Archive> archive);
+
+        /**
+         * Removes every archive from the cache.
+         */
+        void clear();
+
+        /**
+         * Gets the maximum number of archives to keep.
+         * @return  The capacity.
+         */
+        [[nodiscard]] size_t capacity() const
+        {
+            return capacity_;
+        }
+
+    private:
+        /**
+         * An archive in the cache.
+         */
+        struct Entry
+        {
+            uint64_t key;
+            std::shared_ptr<const Archive> archive;
+        };
+
+        /**
+         * Gets the key of an archive.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The key.
+         */
+        static uint64_t key(size_t index, size_t archive)
+        {
+            return (static_cast<uint64_t>(index) << 32) | archive;
+        }
+
+        /**
+         * The maximum number of archives to keep.
+         */
+        size_t capacity_;
+
+        /**
+         * The archives, from most to least recently used.
+         */
+        std::list<Entry> entries_;
+
+        /**
+         * The position of each archive in the recency list.
+         */
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> positions_;
+
+        /**
+         * The mutex guarding the cache.
+         */
+        std::mutex mutex_;
+    };
+}
@@ -3,6 +3,7 @@
 #include <rsfs/jag/FileData.hpp>
 
 #include <array>
+#include <memory_resource>
 #include <vector>
 
 /**
@@ -48,8 +49,9 @@ namespace rsfs
         std::array<char, WHIRLPOOL_SIZE> whirlpool;
 
         /**
-         * The vector of file data for this archive.
+         * The file data for this archive, sorted by id. When an index is loaded, this is allocated from the arena
+         * shared by every archive in the index, whereas copies are allocated from the default resource.
          */
-        std::vector<FileData> files;
+        std::pmr::vector<FileData> files;
     };
 }
\ No newline at end of file
@@ -1,8 +1,29 @@
 #pragma once
 
 #include <rsfs/io/RSBuffer.hpp>
+#include <rsfs/jag/IoHints.hpp>
+#include <rsfs/jag/SectorHeader.hpp>
 
+#include <atomic>
 #include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+/**
+ * The size of a data sector.
+ */
+constexpr const auto SECTOR_SIZE = 520;
+
+/**
+ * The size of a sector with a small header
+ */
+constexpr const auto SMALL_HEADER_SIZE = 8;
+
+/**
+ * The size of a sector with a large header (to support archive ids > 65535)
+ */
+constexpr const auto LARGE_HEADER_SIZE = 10;
 
 namespace rsfs
 {
@@ -14,13 +35,28 @@ namespace rsfs
     {
     public:
         /**
-         * Creates a data file interface from a file stream.
-         * @param stream    The stream.
+         * Opens a data file.
+         * @param path  The path to the data file.
+         * @param hints How the data file will be read.
          */
-        explicit DataFile(std::ifstream stream);
+        explicit DataFile(std::string path, IoHints hints = {});
+
+        /**
+         * Closes the data file.
+         */
+        ~DataFile();
+
+        DataFile(const DataFile&)            = delete;
+        DataFile& operator=(const DataFile&) = delete;
 
         /**
-         * Reads an entry from the data file.
+         * Reopens the data file, such as after the file has been replaced or grown on disk. Reads that are in
+         * progress complete before the file is reopened, and the hints are applied to the new file.
+         */
+        void reopen();
+
+        /**
+         * Reads an entry from the data file. This is safe to call from multiple threads.
          * @param index     The index to read from.
          * @param archive   The archive in the index.
          * @param sector    The sector in the data file.
@@ -29,15 +65,108 @@ namespace rsfs
          */
         RSBuffer read(size_t index, size_t archive, size_t sector, size_t length);
 
+        /**
+         * Asks the operating system to read a run of sectors into the page cache in the background. This is safe to
+         * call from multiple threads, and has no effect on platforms without posix_fadvise.
+         * @param sector    The first sector.
+         * @param count     The number of sectors.
+         */
+        void prefetch(size_t sector, size_t count);
+
+        /**
+         * Decodes the header of a sector.
+         * @param sector        The sector data.
+         * @param largeSector   If the sector has a large header.
+         * @return              The sector header.
+         */
+        static SectorHeader decodeHeader(const char* sector, bool largeSector);
+
+        /**
+         * Encodes the header of a sector.
+         * @param header        The sector header.
+         * @param sector        The sector data to write the header to.
+         * @param largeSector   If the sector has a large header.
+         */
+        static void encodeHeader(const SectorHeader& header, char* sector, bool largeSector);
+
+        /**
+         * Gets the length of the data file.
+         * @return  The length, in bytes.
+         */
+        [[nodiscard]] size_t length() const
+        {
+            return length_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Gets the hints that are applied to the data file.
+         * @return  How the data file is read.
+         */
+        [[nodiscard]] const IoHints& hints() const
+        {
+            return hints_;
+        }
+
     private:
+        /**
+         * Opens the data file and applies the hints to it. The mutex must be held exclusively.
+         */
+        void open();
+
+        /**
+         * Closes the data file. The mutex must be held exclusively.
+         */
+        void close();
+
+        /**
+         * Reads a whole sector. The mutex must be held.
+         * @param sector    The sector.
+         * @param out       The array to read the sector into.
+         */
+        void readSector(size_t sector, char* out);
+
+        /**
+         * Asks the operating system to read a run of sectors in the background. The mutex must be held.
+         * @param sector    The first sector.
+         * @param count     The number of sectors.
+         */
+        void requestSectors(size_t sector, size_t count);
+
+        /**
+         * The path to the data file.
+         */
+        std::string path_;
+
+        /**
+         * How the data file is read.
+         */
+        IoHints hints_;
+
+#ifdef __linux__
+        /**
+         * The file descriptor, which sectors are read from with pread so that reads don't need to be serialised.
+         */
+        int fd_{ -1 };
+#else
         /**
          * The file stream.
          */
         std::ifstream stream_;
 
+        /**
+         * The mutex guarding the position of the file stream.
+         */
+        std::mutex streamMutex_;
+#endif
+
+        /**
+         * The mutex that stops the file from being reopened while it is read from.
+         */
+        std::shared_mutex mutex_;
+
         /**
          * The length of the file.
          */
-        size_t length_{ 0 };
+        std::atomic<size_t> length_{ 0 };
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rsfs
+{
+    /**
+     * Represents how the files in an archive are extracted once the archive has been read.
+     */
+    enum Extraction : uint8_t
+    {
+        /**
+         * Every file is split out of the archive as soon as it is read.
+         */
+        EAGER,
+
+        /**
+         * Only the chunk table is parsed when the archive is read, and files are extracted the first time they are
+         * requested.
+         */
+        ON_DEMAND,
+    };
+}
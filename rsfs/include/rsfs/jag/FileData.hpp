@@ -1,5 +1,7 @@
 #pragma once
-#include <rsfs/io/RSBuffer.hpp>
+
+#include <cstddef>
+#include <span>
 
 namespace rsfs
 {
@@ -19,8 +21,8 @@ namespace rsfs
         size_t nameHash{ 0 };
 
         /**
-         * The buffer representing the contents of the file.
+         * The contents of the file, which is a slice of the data block owned by its archive.
          */
-        RSBuffer contents{ 0 };
+        std::span<const char> contents;
     };
-}
\ No newline at end of file
+}
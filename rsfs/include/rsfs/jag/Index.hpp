@@ -7,6 +7,11 @@ namespace rsfs
      */
     enum Index : size_t
     {
+        /**
+         * The map index, containing the terrain and encrypted landscape archives of each region.
+         */
+        MAPS = 5,
+
         /**
          * The item definition index.
          */
@@ -1,30 +1,45 @@
 #pragma once
 
+#include <rsfs/crypto/XteaKeyStore.hpp>
 #include <rsfs/io/RSBuffer.hpp>
 #include <rsfs/jag/Archive.hpp>
+#include <rsfs/jag/ArchiveCache.hpp>
 #include <rsfs/jag/ArchiveData.hpp>
-#include <rsfs/jag/DataFile.hpp>
-#include <rsfs/jag/IndexEntry.hpp>
+#include <rsfs/store/Store.hpp>
 
 #include <array>
-#include <fstream>
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * The number of locks that archive loads are spread across.
+ */
+constexpr const auto ARCHIVE_LOCK_COUNT = 64;
 
 namespace rsfs
 {
     /**
      * Represents an index in the RuneScape file system. An index acts as a container for multiple file archives.
+     *
+     * Loading a new reference table swaps it in atomically, keeping the loaded contents of the archives whose
+     * revision and checksum are unchanged. References to archives from older tables remain valid until reclaim() is
+     * called.
      */
     class IndexFile
     {
     public:
         /**
-         * Creates an index with a specific metadata stream.
-         * @param stream    The metadata file stream for this index.
-         * @param dataFile  The main data file.
-         * @param id        The id of this index.
+         * Creates an index whose archives are read from a store.
+         * @param store The store.
+         * @param id    The id of this index.
          */
-        IndexFile(std::ifstream stream, DataFile* dataFile, size_t id);
+        IndexFile(Store* store, size_t id);
 
         /**
          * Destroys the resources used by this index.
@@ -32,32 +47,133 @@ namespace rsfs
         ~IndexFile();
 
         /**
-         * Reads the entry data for a specific id from this index.
-         * @param id    The entry id.
-         * @return      The entry data.
+         * Parses the data for this index from a decompressed buffer.
+         * @param buf   The buffer.
+         * @return      The number of archives that were added, changed or removed.
          */
-        IndexEntry read(size_t id);
+        size_t load(RSBuffer& buf);
 
         /**
-         * Parses the data for this index from a decompressed buffer.
-         * @param buf   The buffer.
+         * Sets the function used to load this index the first time its archives or metadata are accessed. The
+         * function is invoked at most once, even when the index is first accessed from several threads at once,
+         * and is retried on the next access if it throws.
+         * @param loader    The loader.
          */
-        void load(RSBuffer& buf);
+        void setLoader(std::function<void(IndexFile&)> loader);
 
         /**
-         * Gets an archive with a specific id
+         * Loads this index from metadata that has already been parsed.
+         * @param protocol  The protocol of the reference table.
+         * @param revision  The revision of the index.
+         * @param named     If the archives have name hashes.
+         * @param whirlpool If the archives have whirlpool digests.
+         * @param archives  The archive metadata.
+         * @param arena     The resource that the file metadata was allocated from, if any. The table is allocated
+         *                  from it too, and it is kept alive for as long as the table or any of its archives.
+         * @return          The number of archives that were added, changed or removed.
+         */
+        size_t load(size_t protocol, size_t revision, bool named, bool whirlpool, std::vector<ArchiveData> archives,
+                    std::shared_ptr<std::pmr::memory_resource> arena = nullptr);
+
+        /**
+         * Encodes a reference table in the format that load() parses.
+         * @param protocol  The protocol of the reference table.
+         * @param revision  The revision of the index.
+         * @param named     If the archives have name hashes.
+         * @param whirlpool If the archives have whirlpool digests.
+         * @param archives  The archive metadata, sorted by id.
+         * @return          The decompressed reference table.
+         */
+        static RSBuffer encode(size_t protocol, size_t revision, bool named, bool whirlpool,
+                               const std::vector<ArchiveData>& archives);
+
+        /**
+         * Checks if a reference table has been loaded for this index.
+         * @return  If the index has been loaded.
+         */
+        [[nodiscard]] bool loaded() const
+        {
+            return current_.load(std::memory_order_acquire) != nullptr;
+        }
+
+        /**
+         * Frees the reference tables, and the archives only they refer to, that have been replaced by a newer
+         * table. The caller must ensure that no references into those tables are still in use.
+         */
+        void reclaim();
+
+        /**
+         * Gets an archive with a specific id, loading it if it hasn't been loaded yet. This is safe to call from
+         * multiple threads.
          * @param archiveId The archive id.
          * @return          The archive.
          */
         Archive& getArchive(size_t archiveId);
 
         /**
-         * Gets the buffer data for a specific archive in this index.
+         * Reads an archive without caching it in this index, such as when every archive is visited once. This is
+         * safe to call from multiple threads.
+         * @param archiveId The archive id.
+         * @return          The archive, with every file extracted.
+         */
+        std::unique_ptr<Archive> loadUncached(size_t archiveId);
+
+        /**
+         * Gets an archive that the caller shares ownership of. An archive that has already been loaded by
+         * getArchive is returned as is. Otherwise the archive is read and decompressed without being kept in this
+         * index, although it is kept in the hot cache if there is one, so memory use stays bounded. This is safe
+         * to call from multiple threads.
+         * @param archiveId The archive id.
+         * @return          The archive, with every file extracted.
+         */
+        std::shared_ptr<const Archive> acquireArchive(size_t archiveId);
+
+        /**
+         * Gets the buffer data for a specific archive in this index. This is safe to call from multiple threads.
          * @param archive   The archive id.
          * @return          The compressed archive data.
          */
         RSBuffer readArchive(size_t archive);
 
+        /**
+         * Sets the key store used to decipher encrypted archives. This must be set before archives are read.
+         * @param keys  The key store, or null if archives should not be deciphered.
+         */
+        void setKeys(const XteaKeyStore* keys);
+
+        /**
+         * Sets when the files in this index's archives are extracted. This must be set before archives are read.
+         * @param extraction    When files should be extracted.
+         */
+        void setExtraction(Extraction extraction);
+
+        /**
+         * Sets the cache that recently acquired archives are kept in. This must be set before archives are read.
+         * @param cache The cache, or null if acquired archives should not be cached.
+         */
+        void setHotCache(ArchiveCache* cache);
+
+        /**
+         * Deciphers an archive container read from this index in place, if there is a key for the archive.
+         * @param archiveId The archive id.
+         * @param container The compressed archive container.
+         */
+        void decipher(size_t archiveId, RSBuffer& container) const;
+
+        /**
+         * Checks if there is a key for an archive, meaning that its container is encrypted.
+         * @param archiveId The archive id.
+         * @return          If the archive is encrypted.
+         */
+        [[nodiscard]] bool encrypted(size_t archiveId) const;
+
+        /**
+         * Gets the key that an archive's container is encrypted with.
+         * @param archiveId The archive id.
+         * @return          The key, or null if the archive isn't encrypted.
+         */
+        [[nodiscard]] const XteaKey* key(size_t archiveId) const;
+
         /**
          * Gets the data for a specific file in an archive.
          * @param archiveId The archive id.
@@ -81,7 +197,34 @@ namespace rsfs
          */
         [[nodiscard]] size_t revision() const
         {
-            return revision_;
+            return table().revision;
+        }
+
+        /**
+         * Gets the protocol of the reference table of this index.
+         * @return  The protocol.
+         */
+        [[nodiscard]] size_t protocol() const
+        {
+            return table().protocol;
+        }
+
+        /**
+         * Checks if the archives in this index have name hashes.
+         * @return  If the archives are named.
+         */
+        [[nodiscard]] bool named() const
+        {
+            return table().named;
+        }
+
+        /**
+         * Checks if the archives in this index have whirlpool digests.
+         * @return  If the archives have whirlpool digests.
+         */
+        [[nodiscard]] bool whirlpool() const
+        {
+            return table().whirlpool;
         }
 
         /**
@@ -90,33 +233,107 @@ namespace rsfs
          */
         [[nodiscard]] size_t archiveCount() const
         {
-            return archives_.size();
+            return table().archives.size();
         }
 
         /**
-         * Gets the number of metadata entries.
-         * @return  The number of entries.
+         * Gets the metadata of an archive, without loading it.
+         * @param archiveId The archive id.
+         * @return          The archive metadata.
          */
-        [[nodiscard]] size_t entryCount() const
-        {
-            return entryCount_;
-        }
+        [[nodiscard]] const ArchiveData& archiveData(size_t archiveId) const;
+
+        /**
+         * Gets the ids of all of the archives in this index.
+         * @return  The sorted archive ids.
+         */
+        [[nodiscard]] std::vector<size_t> archiveIds() const;
 
     private:
         /**
-         * The stream to this index's metadata file.
+         * A parsed reference table. Tables are immutable once published, although their archives are loaded on
+         * demand.
+         */
+        struct ReferenceTable
+        {
+            /**
+             * Creates an empty table.
+             */
+            ReferenceTable() = default;
+
+            /**
+             * Creates an empty table whose archive map is allocated from an arena.
+             * @param arena The arena.
+             */
+            explicit ReferenceTable(std::shared_ptr<std::pmr::memory_resource> arena):
+                arena(std::move(arena)), archives(this->arena.get())
+            {
+            }
+
+            /**
+             * The arena that this table and the metadata of its archives are allocated from. This is declared
+             * first so that it outlives the archive map.
+             */
+            std::shared_ptr<std::pmr::memory_resource> arena;
+
+            /**
+             * The protocol of the reference table.
+             */
+            size_t protocol{ 0 };
+
+            /**
+             * The revision of the index.
+             */
+            size_t revision{ 0 };
+
+            /**
+             * If archives in the index are given a name hash.
+             */
+            bool named{ false };
+
+            /**
+             * If archives in the index contain a whirlpool digest.
+             */
+            bool whirlpool{ false };
+
+            /**
+             * The map of archive ids to the archive instance. Unchanged archives share their contents with older tables.
+             */
+            std::pmr::map<size_t, std::shared_ptr<Archive>> archives;
+        };
+
+        /**
+         * Reads, deciphers and decompresses an archive.
+         * @param archiveId The archive id.
+         * @return          The decompressed archive data.
+         */
+        RSBuffer decompressArchive(size_t archiveId);
+
+        /**
+         * Gets the current reference table, loading this index if it hasn't been loaded yet.
+         * @return  The reference table.
+         */
+        [[nodiscard]] const ReferenceTable& table() const;
+
+        /**
+         * Loads this index through its loader, if it hasn't been loaded yet.
+         */
+        void ensureLoaded() const;
+
+        /**
+         * The function used to load this index on first access.
          */
-        std::ifstream stream_;
+        std::function<void(IndexFile&)> loader_;
 
         /**
-         * The main data file.
+         * Ensures that the loader is only invoked once.
          */
-        DataFile* dataFile_;
+        mutable std::once_flag loaded_;
 
         /**
-         * The number of metadata entries.
+         * The store that archives are read from.
          */
-        size_t entryCount_{ 0 };
+        Store* store_;
 
         /**
          * The id of this index.
@@ -124,28 +341,38 @@ namespace rsfs
         size_t id_{ 0 };
 
         /**
-         * The protocol of this index.
+         * The current reference table.
+         */
+        std::atomic<ReferenceTable*> current_{ nullptr };
+
+        /**
+         * Every reference table that hasn't been reclaimed, including the current one.
+         */
+        std::vector<std::unique_ptr<ReferenceTable>> tables_;
+
+        /**
+         * The mutex guarding table swaps.
          */
-        size_t protocol_{ 0 };
+        std::mutex tableMutex_;
 
         /**
-         * The revision of this index.
+         * The locks guarding archive loads, selected by archive id.
          */
-        size_t revision_{ 0 };
+        std::array<std::mutex, ARCHIVE_LOCK_COUNT> archiveLocks_;
 
         /**
-         * If archives in this index are given a name hash.
+         * The key store used to decipher encrypted archives.
          */
-        bool named_{ false };
+        const XteaKeyStore* keys_{ nullptr };
 
         /**
-         * If archives in this index contain a whirlpool digest.
+         * When the files in this index's archives are extracted.
          */
-        bool whirlpool_{ false };
-        
+        Extraction extraction_{ EAGER };
+
         /**
-         * The map of archive ids to the archive instance.
+         * The cache that recently acquired archives are kept in.
          */
-        std::map<size_t, Archive*> archives_;
+        ArchiveCache* hotCache_{ nullptr };
     };
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rsfs
+{
+    /**
+     * Represents how the data file is expected to be read, which is passed on to the operating system.
+     */
+    enum AccessPattern : uint8_t
+    {
+        /**
+         * The operating system's default readahead is used.
+         */
+        NORMAL,
+
+        /**
+         * Most archives are read in the order they are laid out on disk, such as when exporting or verifying a
+         * whole cache. The operating system reads further ahead.
+         */
+        SEQUENTIAL,
+
+        /**
+         * Archives are read in no particular order, such as when serving players. The operating system doesn't read
+         * ahead, so that nothing is read that won't be used.
+         */
+        RANDOM,
+    };
+
+    /**
+     * The hints given to the operating system about how the data file is read. Hints have no effect on platforms
+     * without posix_fadvise.
+     */
+    struct IoHints
+    {
+        /**
+         * How the data file is expected to be read.
+         */
+        AccessPattern pattern{ NORMAL };
+
+        /**
+         * The number of sectors of a chain that are requested in the background when a read reaches them, or 0 to
+         * leave readahead to the operating system. This is useful with the random access pattern, where the
+         * operating system otherwise reads a multi-sector archive one sector at a time.
+         */
+        size_t readaheadSectors{ 0 };
+    };
+}
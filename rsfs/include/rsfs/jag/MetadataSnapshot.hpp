@@ -0,0 +1,118 @@
+#pragma once
+
+#include <rsfs/jag/IndexFile.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <span>
+#include <string>
+
+namespace rsfs
+{
+    class RSFileSystem;
+
+    /**
+     * A flat, memory mapped copy of the parsed reference tables of every index. Restoring an index from a
+     * snapshot avoids decompressing and parsing its reference table.
+     *
+     * Each index in the snapshot is tagged with the length and checksum of its compressed reference table, so
+     * that an index is only restored if its reference table hasn't changed.
+     */
+    class MetadataSnapshot
+    {
+    public:
+        /**
+         * Writes the reference tables of every index in a filesystem to a snapshot file.
+         * @param fs    The filesystem.
+         * @param path  The path to write the snapshot to.
+         */
+        static void write(RSFileSystem& fs, const std::string& path);
+
+        /**
+         * Maps a snapshot file.
+         * @param path  The path to the snapshot.
+         * @throws std::runtime_error   If the file isn't a snapshot, or was written by an incompatible version.
+         */
+        explicit MetadataSnapshot(const std::string& path);
+
+        /**
+         * Restores an index from this snapshot, if its reference table hasn't changed since the snapshot was written.
+         * @param index   The index to restore.
+         * @param length  The current length of the compressed reference table.
+         * @param crc     The current checksum of the compressed reference table.
+         * @return        If the index was restored.
+         */
+        bool restore(IndexFile& index, size_t length, int crc) const;
+
+    private:
+        /**
+         * The metadata of an index in the snapshot.
+         */
+        struct IndexRecord
+        {
+            uint32_t length;
+            uint32_t reserved;
+            int32_t crc;
+            uint32_t revision;
+            uint8_t protocol;
+            uint8_t named;
+            uint8_t whirlpool;
+            uint8_t present;
+            uint32_t archiveCount;
+            uint64_t firstArchive;
+        };
+
+        /**
+         * The metadata of an archive in the snapshot.
+         */
+        struct ArchiveRecord
+        {
+            uint32_t id;
+            int32_t nameHash;
+            int32_t crc;
+            uint32_t revision;
+            uint64_t firstFile;
+            uint32_t fileCount;
+            uint32_t reserved;
+            std::array<char, WHIRLPOOL_SIZE> whirlpool;
+        };
+
+        /**
+         * The metadata of a file in the snapshot.
+         */
+        struct FileRecord
+        {
+            uint32_t id;
+            uint32_t nameHash;
+        };
+
+        /**
+         * Gets a section of the mapped file.
+         * @param offset    The offset of the section.
+         * @param count     The number of elements in the section.
+         * @return          The section.
+         */
+        template<typename T>
+        std::span<const T> section(uint64_t offset, uint64_t count) const;
+
+        /**
+         * The mapped snapshot file.
+         */
+        boost::iostreams::mapped_file_source file_;
+
+        /**
+         * The index records, indexed by index id.
+         */
+        std::span<const IndexRecord> indices_;
+
+        /**
+         * The archive records of every index.
+         */
+        std::span<const ArchiveRecord> archives_;
+
+        /**
+         * The file records of every archive.
+         */
+        std::span<const FileRecord> files_;
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rsfs
+{
+    /**
+     * Represents the header of a sector in the data file.
+     */
+    struct SectorHeader
+    {
+        /**
+         * The archive that the sector belongs to.
+         */
+        uint32_t archive{ 0 };
+
+        /**
+         * The position of the sector in the archive's sector chain.
+         */
+        uint16_t part{ 0 };
+
+        /**
+         * The next sector in the chain.
+         */
+        uint32_t nextSector{ 0 };
+
+        /**
+         * The index that the sector belongs to.
+         */
+        uint8_t index{ 0 };
+    };
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <rsfs/compression/CompressionType.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * The number of indices that metrics are tracked for, including the metadata index.
+ */
+constexpr const auto METRICS_INDEX_COUNT = 256;
+
+/**
+ * The number of buckets in a latency histogram.
+ */
+constexpr const auto HISTOGRAM_BUCKETS = 32;
+
+namespace rsfs
+{
+    /**
+     * Represents a counter that is tracked for each index.
+     */
+    enum Counter : uint8_t
+    {
+        ARCHIVES_READ,
+        SECTORS_READ,
+        BYTES_READ,
+        BYTES_DECOMPRESSED,
+        CACHE_HITS,
+        CACHE_MISSES,
+        DECOMPRESSION_FAILURES,
+        COUNTER_COUNT,
+    };
+
+    /**
+     * A latency histogram with power-of-two nanosecond buckets. Bucket n holds the samples
+     * in the range [2^n, 2^(n+1)) nanoseconds, with the last bucket holding everything above.
+     */
+    struct Histogram
+    {
+        /**
+         * The number of samples in each bucket.
+         */
+        std::array<uint64_t, HISTOGRAM_BUCKETS> buckets{};
+
+        /**
+         * The total number of samples.
+         */
+        uint64_t count{ 0 };
+
+        /**
+         * The sum of all samples, in nanoseconds.
+         */
+        uint64_t sum{ 0 };
+
+        /**
+         * Gets the bucket that a sample falls into.
+         * @param nanos The sample, in nanoseconds.
+         * @return      The bucket index.
+         */
+        [[nodiscard]] static size_t bucket(uint64_t nanos);
+
+        /**
+         * Estimates a percentile of this histogram, using the upper bound of the bucket it falls into.
+         * @param fraction  The percentile, in the range [0, 1].
+         * @return          The estimated latency, in nanoseconds.
+         */
+        [[nodiscard]] uint64_t percentile(double fraction) const;
+    };
+
+    /**
+     * A point-in-time aggregation of the metrics recorded by every thread.
+     */
+    struct MetricsSnapshot
+    {
+        /**
+         * The counters for each index.
+         */
+        std::array<std::array<uint64_t, COUNTER_COUNT>, METRICS_INDEX_COUNT> counters{};
+
+        /**
+         * The latency of individual sector reads from the data file.
+         */
+        Histogram sectorReads;
+
+        /**
+         * The latency of decompression, for each compression type.
+         */
+        std::array<Histogram, COMPRESSION_TYPES> decompression;
+
+        /**
+         * Gets the value of a counter for an index.
+         * @param index     The index id.
+         * @param counter   The counter.
+         * @return          The value.
+         */
+        [[nodiscard]] uint64_t counter(size_t index, Counter counter) const
+        {
+            return counters.at(index).at(counter);
+        }
+    };
+
+    /**
+     * A static class that records runtime metrics about the filesystem. Every thread records into its own
+     * set of counters, so recording never contends, and the counters are only aggregated when a snapshot
+     * is requested.
+     */
+    class Metrics
+    {
+    public:
+        /**
+         * Increments a counter for an index.
+         * @param index     The index id.
+         * @param counter   The counter.
+         * @param amount    The amount to increment by.
+         */
+        static void increment(size_t index, Counter counter, uint64_t amount = 1);
+
+        /**
+         * Records the latency of a sector read.
+         * @param elapsed   The time taken to read the sector.
+         */
+        static void recordSectorRead(std::chrono::nanoseconds elapsed);
+
+        /**
+         * Records the latency of a decompression.
+         * @param type      The compression type.
+         * @param elapsed   The time taken to decompress the data.
+         */
+        static void recordDecompression(CompressionType type, std::chrono::nanoseconds elapsed);
+
+        /**
+         * Aggregates the metrics recorded by every thread, including threads that have since exited.
+         * @return  The aggregated metrics.
+         */
+        static MetricsSnapshot snapshot();
+    };
+}
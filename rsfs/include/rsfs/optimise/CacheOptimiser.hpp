@@ -0,0 +1,85 @@
+#pragma once
+
+#include <rsfs/RSFileSystem.hpp>
+#include <rsfs/compression/Compression.hpp>
+#include <rsfs/compression/CompressionType.hpp>
+#include <rsfs/store/Store.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rsfs
+{
+    /**
+     * The options used when optimising a cache.
+     */
+    struct OptimiseOptions
+    {
+        /**
+         * The number of worker threads, or 0 to use the number of hardware threads.
+         */
+        size_t threads{ 0 };
+
+        /**
+         * The compression types to try, or empty to only try the types that each index already uses. LZMA is
+         * therefore opt-in: only newer clients can decompress it, so unless it is listed here it is only tried for
+         * the indices that already contain LZMA containers, and older caches stay readable by their clients.
+         */
+        std::vector<CompressionType> types;
+
+        /**
+         * The compression levels to try, for the types that have levels.
+         */
+        std::vector<int> levels{ 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    };
+
+    /**
+     * The totals of an optimisation.
+     */
+    struct OptimiseStats
+    {
+        /**
+         * The number of archives written.
+         */
+        size_t archives{ 0 };
+
+        /**
+         * The number of archives that were written with a smaller container.
+         */
+        size_t recompressed{ 0 };
+
+        /**
+         * The number of archives that were copied unchanged because they are encrypted or couldn't be decompressed.
+         */
+        size_t skipped{ 0 };
+
+        /**
+         * The total size of the archive containers before optimising.
+         */
+        uint64_t bytesBefore{ 0 };
+
+        /**
+         * The total size of the archive containers after optimising.
+         */
+        uint64_t bytesAfter{ 0 };
+    };
+
+    /**
+     * Rewrites a cache with the smallest container for each archive. Every requested compression type and level
+     * is tried in parallel, and a container is only used if it decompresses to exactly the same data as the
+     * original. The reference tables are rewritten with the new checksums and digests, and the revision of each
+     * index that changed is incremented.
+     */
+    class CacheOptimiser
+    {
+    public:
+        /**
+         * Optimises a cache.
+         * @param fs        The filesystem to optimise.
+         * @param out       The store to write the optimised cache to.
+         * @param options   The options to optimise the cache with.
+         * @return          The totals of the optimisation.
+         */
+        static OptimiseStats write(RSFileSystem& fs, Store& out, OptimiseOptions options = {});
+    };
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <rsfs/RSFileSystem.hpp>
+#include <rsfs/compression/CompressionType.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rsfs
+{
+    /**
+     * The layout statistics of an index, or of a whole cache.
+     */
+    struct IndexStats
+    {
+        /**
+         * The index id.
+         */
+        size_t index{ 0 };
+
+        /**
+         * The number of archives with an index entry.
+         */
+        size_t archives{ 0 };
+
+        /**
+         * The total length of the archive containers.
+         */
+        uint64_t bytes{ 0 };
+
+        /**
+         * The number of sectors that the archives span.
+         */
+        uint64_t sectors{ 0 };
+
+        /**
+         * The number of unused bytes at the end of the last sector of each archive.
+         */
+        uint64_t wastedBytes{ 0 };
+
+        /**
+         * The number of times a sector chain jumps somewhere other than the sector that follows it.
+         */
+        uint64_t discontinuities{ 0 };
+
+        /**
+         * The number of archives whose sector chain is truncated, or leads into sectors owned by something else.
+         */
+        size_t brokenChains{ 0 };
+
+        /**
+         * The number of archives that are encrypted, whose decompressed length is unknown.
+         */
+        size_t encrypted{ 0 };
+
+        /**
+         * The total length of the compressed payloads whose decompressed length is known.
+         */
+        uint64_t compressedBytes{ 0 };
+
+        /**
+         * The total decompressed length of those payloads.
+         */
+        uint64_t decompressedBytes{ 0 };
+
+        /**
+         * The number of archives of each compression type.
+         */
+        std::array<size_t, COMPRESSION_TYPES> compressionTypes{};
+
+        /**
+         * Gets the average number of discontinuities in the sector chain of an archive.
+         * @return  The average number of discontinuities.
+         */
+        [[nodiscard]] double averageDiscontinuity() const
+        {
+            return archives > 0 ? static_cast<double>(discontinuities) / archives : 0;
+        }
+
+        /**
+         * Gets the fraction of the sectors' data space that holds archive data.
+         * @return  The sector utilisation, from 0 to 1.
+         */
+        [[nodiscard]] double sectorUtilisation() const
+        {
+            return bytes + wastedBytes > 0 ? static_cast<double>(bytes) / (bytes + wastedBytes) : 0;
+        }
+
+        /**
+         * Gets the compressed length of the payloads as a fraction of their decompressed length.
+         * @return  The compression ratio.
+         */
+        [[nodiscard]] double compressionRatio() const
+        {
+            return decompressedBytes > 0 ? static_cast<double>(compressedBytes) / decompressedBytes : 0;
+        }
+
+        /**
+         * Adds the statistics of another index to these.
+         * @param other The statistics to add.
+         */
+        void add(const IndexStats& other);
+    };
+
+    /**
+     * The layout statistics of a cache.
+     */
+    struct CacheReport
+    {
+        /**
+         * The statistics of each index, including the metadata index.
+         */
+        std::vector<IndexStats> indices;
+
+        /**
+         * The statistics of every index combined.
+         */
+        IndexStats total;
+
+        /**
+         * The number of sectors in the data file, not counting the unused first sector.
+         */
+        uint64_t dataSectors{ 0 };
+
+        /**
+         * The number of sectors that no archive refers to, such as those left behind when archives are replaced.
+         */
+        uint64_t unusedSectors{ 0 };
+    };
+
+    /**
+     * Reports how a cache in the sector layout is laid out on disk, by walking the sector chain of every archive.
+     * The data file is read once, sequentially, and the chains are then followed in memory.
+     */
+    class CacheReporter
+    {
+    public:
+        /**
+         * Analyses the layout of a cache.
+         * @param fs    The filesystem, which must be in the sector layout. Its keys are used to tell which archives
+         *              are encrypted.
+         * @return      The report.
+         */
+        static CacheReport analyse(RSFileSystem& fs);
+
+        /**
+         * Formats a report as JSON.
+         * @param report    The report.
+         * @return          The JSON document.
+         */
+        static std::string toJson(const CacheReport& report);
+    };
+}
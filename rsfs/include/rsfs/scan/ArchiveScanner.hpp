@@ -0,0 +1,79 @@
+#pragma once
+
+#include <rsfs/RSFileSystem.hpp>
+#include <rsfs/compression/CompressionType.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rsfs
+{
+    /**
+     * The options used when scanning a cache.
+     */
+    struct ScanOptions
+    {
+        /**
+         * The number of worker threads, or 0 to use the number of hardware threads.
+         */
+        size_t threads{ 0 };
+
+        /**
+         * The indices to scan, or empty to scan every index.
+         */
+        std::vector<size_t> indices;
+
+        /**
+         * If archives that can't be read should be left out of the scan rather than failing it.
+         */
+        bool skipErrors{ false };
+    };
+
+    /**
+     * The container header of an archive.
+     */
+    struct ArchiveHeader
+    {
+        /**
+         * The archive id.
+         */
+        uint32_t archive{ 0 };
+
+        /**
+         * The length of the compressed payload.
+         */
+        uint32_t compressedLength{ 0 };
+
+        /**
+         * The length of the payload once decompressed.
+         */
+        uint32_t decompressedLength{ 0 };
+
+        /**
+         * The index id.
+         */
+        uint8_t index{ 0 };
+
+        /**
+         * The compression type of the payload.
+         */
+        CompressionType type{ NONE };
+    };
+
+    /**
+     * Reads the container header of every archive in a cache, without reading or decompressing the payloads. Only
+     * the first sector of each archive is read. The decompressed length of an encrypted archive is recovered by
+     * deciphering the first block of its payload.
+     */
+    class ArchiveScanner
+    {
+    public:
+        /**
+         * Scans a cache.
+         * @param fs        The filesystem to scan.
+         * @param options   The options to scan the cache with.
+         * @return          The header of every archive, in index and then archive order.
+         */
+        static std::vector<ArchiveHeader> scan(RSFileSystem& fs, ScanOptions options = {});
+    };
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <rsfs/store/Store.hpp>
+
+#include <array>
+#include <memory>
+#include <span>
+
+namespace rsfs
+{
+    /**
+     * A read-only store that holds the compressed container of every archive in a single contiguous arena. The
+     * containers are read from another store once, when the arena is loaded, so reading an archive afterwards
+     * never touches the disk, and the arena takes about as much memory as the data files do on disk.
+     */
+    class ArenaStore: public Store
+    {
+    public:
+        /**
+         * Reads every container from another store into an arena. The containers are read in parallel, and
+         * copied straight into their place in the arena.
+         * @param source    The store to read from.
+         * @param threads   The number of threads to read with, or 0 to use the number of hardware threads.
+         * @return          The arena store.
+         */
+        static std::unique_ptr<ArenaStore> load(Store& source, size_t threads = 0);
+
+        /**
+         * Copies the compressed container of an archive out of the arena. This is safe to call from multiple
+         * threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The compressed container.
+         */
+        RSBuffer read(size_t index, size_t archive) override;
+
+        /**
+         * Gets the length of the compressed container of an archive.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The length, in bytes.
+         */
+        [[nodiscard]] size_t length(size_t index, size_t archive) override;
+
+        /**
+         * Copies the start of the compressed container of an archive out of the arena.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param length    The maximum number of bytes to read.
+         * @return          The start of the container.
+         */
+        RSBuffer readPrefix(size_t index, size_t archive, size_t length) override;
+
+        /**
+         * Gets the compressed container of an archive in the arena, without copying it.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The container, which remains valid for the lifetime of this store.
+         */
+        [[nodiscard]] std::optional<std::span<const char>> view(size_t index, size_t archive) override;
+
+        /**
+         * Arena stores are read-only.
+         * @throws std::runtime_error   Always.
+         */
+        void write(size_t index, size_t archive, const RSBuffer& container) override;
+
+        /**
+         * Gets the ids of the archives that are held for an index.
+         * @param index The index id.
+         * @return      The sorted archive ids.
+         */
+        [[nodiscard]] std::vector<size_t> archiveIds(size_t index) override;
+
+        /**
+         * Gets the number of indices in the store that the arena was loaded from.
+         * @return  The number of indices.
+         */
+        [[nodiscard]] size_t indexCount() override
+        {
+            return indexCount_;
+        }
+
+        /**
+         * Gets the compressed container of an archive, without copying it.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The container, which remains valid for the lifetime of this store.
+         * @throws std::runtime_error   If the archive doesn't exist.
+         */
+        [[nodiscard]] std::span<const char> container(size_t index, size_t archive) const;
+
+        /**
+         * Gets the size of the arena.
+         * @return  The size, in bytes.
+         */
+        [[nodiscard]] size_t size() const
+        {
+            return size_;
+        }
+
+    private:
+        /**
+         * The location of a container in the arena.
+         */
+        struct Extent
+        {
+            uint64_t offset{ 0 };
+            uint32_t length{ 0 };
+            bool present{ false };
+        };
+
+        /**
+         * The arena of containers.
+         */
+        std::unique_ptr<char[]> arena_;
+
+        /**
+         * The size of the arena.
+         */
+        size_t size_{ 0 };
+
+        /**
+         * The number of indices.
+         */
+        size_t indexCount_{ 0 };
+
+        /**
+         * The location of each container, indexed by index id and then archive id.
+         */
+        std::array<std::vector<Extent>, METADATA_INDEX + 1> extents_;
+    };
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <rsfs/store/Store.hpp>
+
+#include <filesystem>
+#include <string>
+
+namespace rsfs
+{
+    /**
+     * A store with one file per archive. The compressed container of an archive is stored at
+     * <index>/<archive>.dat, so rebuilding a single archive only rewrites its own file. Reference tables are
+     * stored in the 255 directory.
+     */
+    class FlatFileStore: public Store
+    {
+    public:
+        /**
+         * Opens a flat store in a directory. The directory is created when an archive is first written.
+         * @param path  The path to the directory.
+         */
+        explicit FlatFileStore(std::string path);
+
+        /**
+         * Reads the compressed container of an archive. This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The compressed container.
+         */
+        RSBuffer read(size_t index, size_t archive) override;
+
+        /**
+         * Gets the length of the compressed container of an archive from the size of its file.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The length, in bytes.
+         */
+        [[nodiscard]] size_t length(size_t index, size_t archive) override;
+
+        /**
+         * Reads the start of the compressed container of an archive, without reading the rest of its file.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param length    The maximum number of bytes to read.
+         * @return          The start of the container.
+         */
+        RSBuffer readPrefix(size_t index, size_t archive, size_t length) override;
+
+        /**
+         * Writes the compressed container of an archive. The file is replaced atomically, so readers see either
+         * the old or the new container.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param container The compressed container.
+         */
+        void write(size_t index, size_t archive, const RSBuffer& container) override;
+
+        /**
+         * Gets the ids of the archives that have a file in an index's directory.
+         * @param index The index id.
+         * @return      The sorted archive ids.
+         */
+        [[nodiscard]] std::vector<size_t> archiveIds(size_t index) override;
+
+        /**
+         * Gets the number of indices, which is one more than the highest reference table id.
+         * @return  The number of indices.
+         */
+        [[nodiscard]] size_t indexCount() override;
+
+    private:
+        /**
+         * Gets the path to the file of an archive.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The archive path.
+         */
+        [[nodiscard]] std::filesystem::path archivePath(size_t index, size_t archive) const;
+
+        /**
+         * The path to the directory.
+         */
+        std::filesystem::path path_;
+    };
+}
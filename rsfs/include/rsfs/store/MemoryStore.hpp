@@ -0,0 +1,74 @@
+#pragma once
+
+#include <rsfs/store/Store.hpp>
+
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <utility>
+
+namespace rsfs
+{
+    /**
+     * A store that holds every compressed container in memory. This is useful for tests, which can build a
+     * cache without touching the disk, and for services that can't afford to wait on disk reads.
+     */
+    class MemoryStore: public Store
+    {
+    public:
+        /**
+         * Copies every container from another store into memory.
+         * @param source    The store to copy.
+         * @return          The in-memory copy.
+         */
+        static std::unique_ptr<MemoryStore> copy(Store& source);
+
+        /**
+         * Reads the compressed container of an archive. This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The compressed container.
+         */
+        RSBuffer read(size_t index, size_t archive) override;
+
+        /**
+         * Gets the length of the compressed container of an archive.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The length, in bytes.
+         */
+        [[nodiscard]] size_t length(size_t index, size_t archive) override;
+
+        /**
+         * Writes the compressed container of an archive. This is safe to call while other threads are reading.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param container The compressed container.
+         */
+        void write(size_t index, size_t archive, const RSBuffer& container) override;
+
+        /**
+         * Gets the ids of the archives that are held for an index.
+         * @param index The index id.
+         * @return      The sorted archive ids.
+         */
+        [[nodiscard]] std::vector<size_t> archiveIds(size_t index) override;
+
+        /**
+         * Gets the number of indices, which is one more than the highest reference table id.
+         * @return  The number of indices.
+         */
+        [[nodiscard]] size_t indexCount() override;
+
+    private:
+        /**
+         * The containers, keyed by index and archive id.
+         */
+        std::map<std::pair<size_t, size_t>, RSBuffer> containers_;
+
+        /**
+         * The mutex guarding the containers.
+         */
+        std::shared_mutex mutex_;
+    };
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <rsfs/jag/DataFile.hpp>
+#include <rsfs/jag/IndexEntry.hpp>
+#include <rsfs/store/Store.hpp>
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace rsfs
+{
+    /**
+     * A store in the classic sector layout. Archives are split into sectors of main_file_cache.dat2, and the
+     * first sector and length of each archive are found in the main_file_cache.idx file of its index. Index
+     * files are opened when they are first read from.
+     *
+     * Written containers are appended to the end of the data file in a new chain of sectors, and the sectors of
+     * the container they replace are left unused. The data file stays open for writing, and index entries are
+     * held in memory, until the writes are flushed.
+     */
+    class SectorStore: public Store
+    {
+    public:
+        /**
+         * Opens the data files in a directory.
+         * @param path  The path to the directory, including a trailing separator.
+         * @param hints How the data file will be read.
+         */
+        explicit SectorStore(std::string path, IoHints hints = {});
+
+        /**
+         * Creates an empty store in a directory, or opens the store if its data files already exist.
+         * @param path  The path to the directory, including a trailing separator.
+         * @return      The store.
+         */
+        static std::unique_ptr<SectorStore> create(const std::string& path);
+
+        /**
+         * Flushes the writes that haven't been flushed yet.
+         */
+        ~SectorStore() override;
+
+        /**
+         * Reads the compressed container of an archive. This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The compressed container.
+         */
+        RSBuffer read(size_t index, size_t archive) override;
+
+        /**
+         * Gets the length of the compressed container of an archive from its index file.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The length, in bytes.
+         */
+        [[nodiscard]] size_t length(size_t index, size_t archive) override;
+
+        /**
+         * Reads the start of the compressed container of an archive, from only the sectors that it spans.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param length    The maximum number of bytes to read.
+         * @return          The start of the container.
+         */
+        RSBuffer readPrefix(size_t index, size_t archive, size_t length) override;
+
+        /**
+         * Writes the compressed container of an archive, appending it to the data file. The container is read
+         * from its old location until the writes are flushed. Writes are serialised, and are safe to make while
+         * other threads are reading.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param container The compressed container.
+         */
+        void write(size_t index, size_t archive, const RSBuffer& container) override;
+
+        /**
+         * Writes the index entries of the containers written since the last flush, and reopens the files so that
+         * readers see them.
+         */
+        void flush() override;
+
+        /**
+         * Gets the ids of the archives that have an entry in an index file.
+         * @param index The index id.
+         * @return      The sorted archive ids.
+         */
+        [[nodiscard]] std::vector<size_t> archiveIds(size_t index) override;
+
+        /**
+         * Gets the number of indices, which is the number of entries in the metadata index file.
+         * @return  The number of indices.
+         */
+        [[nodiscard]] size_t indexCount() override;
+
+        /**
+         * Reopens the data file, and closes the index files so that they are reopened the next time they are
+         * read from.
+         */
+        void reopen() override;
+
+        /**
+         * Asks the operating system to read the sectors of every archive in an index into the page cache in the
+         * background, so that the first read of each archive doesn't wait for the disk. Sector chains are assumed
+         * to be contiguous, as they are when written by write, and the rest of a fragmented chain is read on demand.
+         * @param index The index id.
+         */
+        void preload(size_t index);
+
+        /**
+         * Reads the entry of an archive from its index file. This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The entry.
+         */
+        [[nodiscard]] IndexEntry entry(size_t index, size_t archive);
+
+        /**
+         * Reads every entry of an index file at once. This is safe to call from multiple threads.
+         * @param index The index id.
+         * @return      The entries, by archive id. Archives without data have an empty entry.
+         */
+        [[nodiscard]] std::vector<IndexEntry> entries(size_t index);
+
+        /**
+         * Gets the path to the data file.
+         * @return  The data file path.
+         */
+        [[nodiscard]] std::string dataPath() const;
+
+        /**
+         * Gets the number of times the data file has been reopened, including when written containers are flushed.
+         * Readers that open the data file themselves reopen it when this changes, so that they never read it from
+         * before the index entries.
+         * @return  The generation of the data file.
+         */
+        [[nodiscard]] uint64_t generation() const
+        {
+            return generation_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Gets the hints that are applied to the data file, which readers that open the data file themselves apply
+         * to it too.
+         * @return  How the data file is read.
+         */
+        [[nodiscard]] const IoHints& hints() const
+        {
+            return dataFile_->hints();
+        }
+
+    private:
+        /**
+         * An index file, and the mutex guarding it.
+         */
+        struct IndexStream
+        {
+            std::ifstream stream;
+            std::mutex mutex;
+            size_t entryCount{ 0 };
+        };
+
+        /**
+         * Opens an index file, if it hasn't been opened yet. The stream's mutex must be held.
+         * @param index     The index id.
+         * @param stream    The stream of the index.
+         */
+        void openStream(size_t index, IndexStream& stream) const;
+
+        /**
+         * Gets the path to an index file.
+         * @param id    The id of the index.
+         * @return      The index file path.
+         */
+        [[nodiscard]] std::string indexPath(size_t id) const;
+
+        /**
+         * The path to the directory of data files.
+         */
+        std::string path_;
+
+        /**
+         * The main data file.
+         */
+        std::unique_ptr<DataFile> dataFile_;
+
+        /**
+         * The index files, indexed by index id.
+         */
+        std::array<IndexStream, METADATA_INDEX + 1> streams_;
+
+        /**
+         * The mutex serialising writes, and guarding the write state.
+         */
+        std::mutex writeMutex_;
+
+        /**
+         * The data file, opened for writing by the first write since the last flush.
+         */
+        std::fstream dataWriter_;
+
+        /**
+         * The length of the data file, including the chains written since the last flush.
+         */
+        size_t dataEnd_{ 0 };
+
+        /**
+         * The entries of the containers written since the last flush, by index id.
+         */
+        std::map<size_t, std::vector<std::pair<size_t, IndexEntry>>> pendingEntries_;
+
+        /**
+         * The generation of the data file.
+         */
+        std::atomic<uint64_t> generation_{ 0 };
+    };
+}
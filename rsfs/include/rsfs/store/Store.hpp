@@ -0,0 +1,139 @@
+#pragma once
+
+#include <rsfs/io/RSBuffer.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+/**
+ * The id of the metadata index, which holds the reference table of every other index.
+ */
+constexpr const auto METADATA_INDEX = 255;
+
+namespace rsfs
+{
+    /**
+     * The storage layouts that a filesystem can be opened from.
+     */
+    enum StoreLayout : uint8_t
+    {
+        /**
+         * The classic layout, where archives are split into sectors of main_file_cache.dat2, and located
+         * through main_file_cache.idx files.
+         */
+        SECTOR,
+
+        /**
+         * One file per archive, at <index>/<archive>.dat, holding the archive's compressed container.
+         */
+        FLAT
+    };
+
+    /**
+     * The storage that the compressed containers of a filesystem are read from. The reference tables are stored
+     * as the archives of the metadata index.
+     */
+    class Store
+    {
+    public:
+        /**
+         * Destroys the resources used by this store.
+         */
+        virtual ~Store() = default;
+
+        /**
+         * Reads the compressed container of an archive. This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The compressed container.
+         * @throws std::runtime_error   If the archive doesn't exist.
+         */
+        virtual RSBuffer read(size_t index, size_t archive) = 0;
+
+        /**
+         * Gets the length of the compressed container of an archive, without reading it if the store can avoid it.
+         * This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The length, in bytes.
+         * @throws std::runtime_error   If the archive doesn't exist.
+         */
+        [[nodiscard]] virtual size_t length(size_t index, size_t archive)
+        {
+            return read(index, archive).getSize();
+        }
+
+        /**
+         * Reads the start of the compressed container of an archive, such as its header, without reading the rest
+         * of it if the store can avoid it. This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param length    The maximum number of bytes to read.
+         * @return          The start of the container, which is shorter than the length if the container is.
+         * @throws std::runtime_error   If the archive doesn't exist.
+         */
+        virtual RSBuffer readPrefix(size_t index, size_t archive, size_t length)
+        {
+            auto container = read(index, archive);
+            if (container.getSize() > length)
+                container.resize(length);
+            return container;
+        }
+
+        /**
+         * Gets the compressed container of an archive without copying it, for stores that hold their containers in
+         * memory that is never written to. This is safe to call from multiple threads.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @return          The container, which remains valid for the lifetime of this store, or nothing if the
+         *                  container has to be read.
+         * @throws std::runtime_error   If the archive doesn't exist.
+         */
+        [[nodiscard]] virtual std::optional<std::span<const char>> view(size_t /* index */, size_t /* archive */)
+        {
+            return std::nullopt;
+        }
+
+        /**
+         * Writes the compressed container of an archive, replacing it if it already exists. Some stores only make
+         * the container visible to readers once the writes are flushed.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param container The compressed container.
+         * @throws std::runtime_error   If the store is read-only.
+         */
+        virtual void write(size_t index, size_t archive, const RSBuffer& container) = 0;
+
+        /**
+         * Finishes the writes made since the last flush, and makes them visible to readers. Stores that write
+         * through immediately do nothing.
+         * @throws std::runtime_error   If the writes couldn't be finished.
+         */
+        virtual void flush()
+        {
+        }
+
+        /**
+         * Gets the ids of the archives that are stored in an index.
+         * @param index The index id.
+         * @return      The sorted archive ids.
+         */
+        [[nodiscard]] virtual std::vector<size_t> archiveIds(size_t index) = 0;
+
+        /**
+         * Gets the number of indices, which is the number of reference tables in the metadata index.
+         * @return  The number of indices.
+         */
+        [[nodiscard]] virtual size_t indexCount() = 0;
+
+        /**
+         * Picks up changes made to the underlying storage since it was opened, such as files that have been
+         * replaced on disk.
+         */
+        virtual void reopen()
+        {
+        }
+    };
+}
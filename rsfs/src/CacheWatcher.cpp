@@ -0,0 +1,152 @@
+#include <rsfs/CacheWatcher.hpp>
+#include <rsfs/store/SectorStore.hpp>
+
+#include <glog/logging.h>
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace rsfs;
+
+/**
+ * The prefix shared by the names of the cache files.
+ */
+constexpr const auto CACHE_FILE_PREFIX = std::string_view("main_file_cache");
+
+/**
+ * The size of the buffer that inotify events are read into.
+ */
+constexpr const auto EVENT_BUFFER_SIZE = 4096;
+
+/**
+ * Starts watching a filesystem.
+ * @param fs        The filesystem to reload.
+ * @param settle    The time to wait after the last change before reloading.
+ * @param callback  The function invoked after a reload that changed any indices.
+ */
+CacheWatcher::CacheWatcher(RSFileSystem& fs, std::chrono::milliseconds settle, Callback callback)
+    : fs_(fs), settle_(settle), callback_(std::move(callback))
+{
+#ifdef __linux__
+    if (!dynamic_cast<SectorStore*>(&fs_.store()))
+        throw std::runtime_error("Only filesystems in the sector layout can be watched");
+
+    inotify_ = inotify_init1(IN_CLOEXEC);
+    if (inotify_ < 0)
+        throw std::runtime_error("Unable to initialise inotify");
+
+    auto directory = fs_.path().empty() ? std::string(".") : fs_.path();
+    if (inotify_add_watch(inotify_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MODIFY) < 0)
+    {
+        close(inotify_);
+        throw std::runtime_error("Unable to watch the cache directory");
+    }
+
+    wake_ = eventfd(0, EFD_CLOEXEC);
+    if (wake_ < 0)
+    {
+        close(inotify_);
+        throw std::runtime_error("Unable to create the watcher wake-up event");
+    }
+
+    thread_ = std::thread(&CacheWatcher::run, this);
+#else
+    throw std::runtime_error("Watching the cache is only supported on Linux");
+#endif
+}
+
+/**
+ * Stops watching the filesystem.
+ */
+CacheWatcher::~CacheWatcher()
+{
+#ifdef __linux__
+    uint64_t value = 1;
+    if (write(wake_, &value, sizeof(value)) != sizeof(value))
+        LOG(ERROR) << "Unable to wake the cache watcher";
+    thread_.join();
+
+    close(wake_);
+    close(inotify_);
+#endif
+}
+
+/**
+ * Waits for changes to the cache files, and reloads the filesystem once they settle.
+ */
+void CacheWatcher::run()
+{
+#ifdef __linux__
+    using clock = std::chrono::steady_clock;
+
+    auto pending  = false;
+    auto deadline = clock::now();
+    alignas(inotify_event) std::array<char, EVENT_BUFFER_SIZE> events{};
+
+    while (true)
+    {
+        // Wait for a change, or for the files to settle after the last change
+        auto timeout = -1;
+        if (pending)
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+            timeout        = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+        }
+
+        std::array<pollfd, 2> fds{ { { inotify_, POLLIN, 0 }, { wake_, POLLIN, 0 } } };
+        auto ready = poll(fds.data(), fds.size(), timeout);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LOG(ERROR) << "Unable to poll for cache changes: " << std::strerror(errno);
+            return;
+        }
+
+        if (fds[1].revents & POLLIN)
+            return;
+
+        if (fds[0].revents & POLLIN)
+        {
+            auto length = read(inotify_, events.data(), events.size());
+            for (auto offset = 0l; offset < length;)
+            {
+                auto* event = reinterpret_cast<const inotify_event*>(events.data() + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                if (event->len > 0 && std::string_view(event->name).starts_with(CACHE_FILE_PREFIX))
+                {
+                    pending  = true;
+                    deadline = clock::now() + settle_;
+                }
+            }
+            continue;
+        }
+
+        // The files have settled, so reload the filesystem
+        if (!pending || clock::now() < deadline)
+            continue;
+        pending = false;
+
+        try
+        {
+            auto reloaded = fs_.reload();
+            if (!reloaded.empty() && callback_)
+                callback_(reloaded);
+        }
+        catch (const std::exception& e)
+        {
+            LOG(WARNING) << "Unable to reload the cache: " << e.what();
+        }
+    }
+#endif
+}
@@ -1,65 +1,73 @@
 #include <rsfs/RSFileSystem.hpp>
 #include <rsfs/compression/Compression.hpp>
+#include <rsfs/jag/MetadataSnapshot.hpp>
+#include <rsfs/metrics/Metrics.hpp>
+#include <rsfs/store/ArenaStore.hpp>
+#include <rsfs/store/FlatFileStore.hpp>
+#include <rsfs/store/SectorStore.hpp>
 
 #include <boost/crc.hpp>
 #include <glog/logging.h>
 
 #include <cassert>
 #include <crypto++/whrlpool.h>
-#include <sstream>
+#include <memory>
 
 using namespace rsfs;
 
 /**
- * The name of the data file.
- */
-constexpr auto DATA_NAME = "main_file_cache.dat2";
-
-/**
- * The name of an index file, without the trailing id.
- */
-constexpr auto INDEX_NAME = "main_file_cache.idx";
-
-/**
- * The id of the metadata index file.
+ * Initialises the RuneScape filesystem.
+ * @param path      The path to the RuneScape data files.
+ * @param options   The options to open the filesystem with.
  */
-constexpr auto METADATA_INDEX = 255;
+RSFileSystem::RSFileSystem(const std::string_view& path, FileSystemOptions options)
+    : RSFileSystem(openStore(path, options), options)
+{
+    path_ = path;
+}
 
 /**
- * Initialises the RuneScape filesystem.
- * @param path  The path to the RuneScape data files.
+ * Initialises the RuneScape filesystem from a store.
+ * @param store     The store that the data files are read from.
+ * @param options   The options to open the filesystem with.
  */
-RSFileSystem::RSFileSystem(const std::string_view& path): indices_({})
+RSFileSystem::RSFileSystem(std::unique_ptr<Store> store, FileSystemOptions options)
+    : options_(std::move(options)), store_(std::move(store)), indices_({})
 {
-    // A helper function used to get the path to an index file with a specified id
-    auto getIndexFile = [path](auto id) {
-        std::stringstream stream;
-        stream << path << INDEX_NAME << id;
-        return stream.str();
-    };
-
-    // The flags to open a file with
-    auto fileFlags = std::ios::in | std::ios::binary | std::ios::ate;
+    // Read every container into memory, and release the original store along with any files it holds open
+    if (options_.inMemory)
+        store_ = ArenaStore::load(*store_);
+    indexCount_ = store_->indexCount();
 
-    // Open the data file
-    std::stringstream stream;
-    stream << path << DATA_NAME;
-    dataFile_ = new DataFile(std::ifstream(stream.str(), fileFlags));
+    if (options_.hotCacheSize > 0)
+        hotCache_ = std::make_unique<ArchiveCache>(options_.hotCacheSize);
 
-    // Parse the metadata index
-    metadataIndex_ = new IndexFile(std::ifstream(getIndexFile(METADATA_INDEX), fileFlags), dataFile_, METADATA_INDEX);
-    indexCount_    = metadataIndex_->entryCount();
+    // Load the keys used to decipher encrypted archives
+    if (!options_.xteaKeys.empty())
+        keys_ = XteaKeyStore::load(options_.xteaKeys);
 
-    // Parse the other indices
+    // Create the indices, which read their archives from the store
     indices_.reserve(indexCount_);
+    tableChecksums_.resize(indexCount_);
     for (size_t idx = 0; idx < indexCount_; idx++)
     {
-        auto* index = new IndexFile(std::ifstream(getIndexFile(idx), fileFlags), dataFile_, idx);
+        auto* index = new IndexFile(store_.get(), idx);
+        index->setKeys(&keys_);
+        index->setExtraction(options_.extraction);
+        index->setHotCache(hotCache_.get());
         indices_.push_back(index);
     }
 
-    // Load the indices
-    loadIndices();
+    // Load the indices up front, unless they should be loaded on first access
+    if (!options_.lazy)
+    {
+        loadIndices();
+        return;
+    }
+
+    snapshot_ = openSnapshot();
+    for (auto* index: indices_)
+        index->setLoader([this](IndexFile& index) { loadIndex(index, snapshot_.get()); });
 }
 
 /**
@@ -69,8 +77,6 @@ RSFileSystem::~RSFileSystem()
 {
     for (auto* index: indices_)
         delete index;
-    delete metadataIndex_;
-    delete dataFile_;
 }
 
 /**
@@ -81,8 +87,7 @@ RSFileSystem::~RSFileSystem()
 RSBuffer RSFileSystem::readIndex(size_t id) const
 {
     assert(indices_.size() > id);
-    auto entry = metadataIndex_->read(id);
-    return dataFile_->read(METADATA_INDEX, id, entry.sector, entry.length);
+    return store_->read(METADATA_INDEX, id);
 }
 
 /**
@@ -90,14 +95,150 @@ RSBuffer RSFileSystem::readIndex(size_t id) const
  */
 void RSFileSystem::loadIndices()
 {
+    auto snapshot = openSnapshot();
+
+    auto stale = false;
     for (auto&& index: indices_)
     {
-        // Read the data for the index.
-        RSBuffer data     = readIndex(index->getId());
-        auto decompressed = Compression::decompress(data.resetReaderIndex());
+        if (!loadIndex(*index, snapshot.get()))
+            stale = true;
+    }
+
+    // Bring the snapshot up to date for the next time the filesystem is opened
+    if (!options_.metadataSnapshot.empty() && stale)
+    {
+        snapshot.reset();
+        try
+        {
+            MetadataSnapshot::write(*this, options_.metadataSnapshot);
+        }
+        catch (const std::exception& e)
+        {
+            LOG(WARNING) << "Unable to write metadata snapshot: " << e.what();
+        }
+    }
+}
+
+/**
+ * Loads a single index, restoring it from a metadata snapshot if its reference table hasn't changed.
+ * @param index     The index to load.
+ * @param snapshot  The metadata snapshot, or null if there isn't one.
+ * @return          If the index was restored from the snapshot.
+ */
+bool RSFileSystem::loadIndex(IndexFile& index, const MetadataSnapshot* snapshot)
+{
+    // Read the data for the index
+    RSBuffer data = readIndex(index.getId());
+    auto checksum = tableChecksum(data);
+
+    // Remember the checksum, so that changes can be detected when reloading
+    tableChecksums_.at(index.getId()) = checksum;
+
+    // Restore the index from the snapshot if its reference table hasn't changed
+    if (snapshot && snapshot->restore(index, data.getSize(), static_cast<int>(checksum)))
+        return true;
+
+    parseIndex(index, data);
+    return false;
+}
 
-        // Load the data from the index
-        index->load(decompressed);
+/**
+ * Decompresses and parses the reference table of an index.
+ * @param index The index.
+ * @param data  The compressed reference table.
+ * @return      The number of archives that were added, changed or removed.
+ */
+size_t RSFileSystem::parseIndex(IndexFile& index, RSBuffer& data) const
+{
+    RSBuffer decompressed;
+    try
+    {
+        decompressed = Compression::decompress(data.resetReaderIndex());
+    }
+    catch (...)
+    {
+        Metrics::increment(METADATA_INDEX, DECOMPRESSION_FAILURES);
+        throw;
+    }
+    Metrics::increment(METADATA_INDEX, BYTES_DECOMPRESSED, decompressed.getSize());
+
+    // Load the data from the index
+    return index.load(decompressed);
+}
+
+/**
+ * Calculates the checksum of a compressed reference table.
+ * @param data  The compressed reference table.
+ * @return      The CRC32 checksum.
+ */
+uint32_t RSFileSystem::tableChecksum(const RSBuffer& data)
+{
+    boost::crc_32_type checksum;
+    checksum.process_block(data.begin(), data.end());
+    return checksum.checksum();
+}
+
+/**
+ * Re-reads the metadata index, and reloads the indices whose reference tables have changed.
+ * @return  The ids of the indices that were reloaded.
+ */
+std::vector<size_t> RSFileSystem::reload()
+{
+    std::lock_guard lock(reloadMutex_);
+
+    // Pick up files that have been replaced or grown since they were opened
+    store_->reopen();
+
+    if (store_->indexCount() != indexCount_)
+        LOG(WARNING) << "The number of indices has changed, only existing indices will be reloaded";
+
+    std::vector<size_t> reloaded;
+    for (auto* index: indices_)
+    {
+        // Indices that haven't been loaded yet will read the new reference table when they are first accessed
+        if (!index->loaded())
+            continue;
+
+        auto id   = index->getId();
+        auto data = readIndex(id);
+        auto crc  = tableChecksum(data);
+        if (crc == tableChecksums_.at(id))
+            continue;
+
+        auto changed           = parseIndex(*index, data);
+        tableChecksums_.at(id) = crc;
+        reloaded.push_back(id);
+        LOG(INFO) << "Reloaded index " << id << ", " << changed << " archives changed";
+    }
+    return reloaded;
+}
+
+/**
+ * Frees the reference tables and archives that have been replaced by a reload.
+ */
+void RSFileSystem::reclaim()
+{
+    for (auto* index: indices_)
+        index->reclaim();
+}
+
+/**
+ * Opens the metadata snapshot, if one was requested.
+ * @return  The snapshot, or null if there isn't one or it couldn't be opened.
+ */
+std::unique_ptr<MetadataSnapshot> RSFileSystem::openSnapshot() const
+{
+    if (options_.metadataSnapshot.empty())
+        return nullptr;
+
+    try
+    {
+        return std::make_unique<MetadataSnapshot>(options_.metadataSnapshot);
+    }
+    catch (const std::exception& e)
+    {
+        LOG(INFO) << "Unable to open metadata snapshot, parsing reference tables: " << e.what();
+        return nullptr;
     }
 }
 
@@ -113,13 +254,22 @@ IndexFile& RSFileSystem::getIndex(size_t id) const
     return *idx;
 }
 
+/**
+ * Sets the keys used to decipher encrypted archives.
+ * @param keys  The key store.
+ */
+void RSFileSystem::setKeys(XteaKeyStore keys)
+{
+    keys_ = std::move(keys);
+}
+
 /**
  * Builds the checksum table for this file system.
  * @param whirlpool If we should calculate the whirlpool digests.
  */
 void RSFileSystem::buildChecksumTable(bool whirlpool)
 {
-    auto entryCount = metadataIndex_->entryCount();
+    auto entryCount = indexCount_;
 
     // Calculate the length of the checksum table
     auto length = 1 + entryCount * 8;
@@ -189,4 +339,32 @@ void RSFileSystem::buildChecksumTable(bool whirlpool)
 RSBuffer RSFileSystem::checksumTable() const
 {
     return checksumTable_;
-}
\ No newline at end of file
+}
+
+/**
+ * Opens the store for a path.
+ * @param path      The path to the RuneScape data files.
+ * @param options   The options that the filesystem is opened with.
+ * @return          The store.
+ */
+std::unique_ptr<Store> RSFileSystem::openStore(const std::string_view& path, const FileSystemOptions& options)
+{
+    switch (options.layout)
+    {
+        case SECTOR:
+        {
+            auto store = std::make_unique<SectorStore>(std::string(path), options.ioHints);
+
+            // An in-memory filesystem reads every archive straight away, so there is nothing to preload
+            if (!options.inMemory)
+            {
+                for (auto index: options.preloadIndices)
+                    store->preload(index);
+            }
+            return store;
+        }
+        case FLAT:
+            return std::make_unique<FlatFileStore>(std::string(path));
+    }
+    throw std::runtime_error("Unknown store layout");
+}
@@ -0,0 +1,217 @@
+#include "async/IoUringBackend.hpp"
+#include "util/Parallel.hpp"
+
+#include <rsfs/async/AsyncReader.hpp>
+#include <rsfs/compression/Compression.hpp>
+#include <rsfs/metrics/Metrics.hpp>
+#include <rsfs/store/SectorStore.hpp>
+
+#include <boost/asio/post.hpp>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * Deciphers and decompresses an archive, recording the outcome against its index.
+     * @param index     The index.
+     * @param archive   The archive id.
+     * @param data      The compressed archive data.
+     * @return          The decompressed archive data.
+     */
+    RSBuffer decompressArchive(const IndexFile& index, size_t archive, RSBuffer& data)
+    {
+        index.decipher(archive, data);
+        try
+        {
+            auto decompressed = Compression::decompress(data);
+            Metrics::increment(index.getId(), BYTES_DECOMPRESSED, decompressed.getSize());
+            return decompressed;
+        }
+        catch (...)
+        {
+            Metrics::increment(index.getId(), DECOMPRESSION_FAILURES);
+            throw;
+        }
+    }
+
+    /**
+     * Creates the io_uring backend for a store, if the store is in the sector layout.
+     * @param sectors       The sector store, or null if the store is in another layout.
+     * @param queueDepth    The maximum number of sector reads submitted at once.
+     * @return              The backend, or null if it is unavailable.
+     */
+    std::unique_ptr<IoUringBackend> createRing(SectorStore* sectors, size_t queueDepth)
+    {
+        if (!sectors)
+            return nullptr;
+        return IoUringBackend::create(sectors->dataPath(), queueDepth, sectors->hints());
+    }
+}
+
+/**
+ * Starts the read, and resumes the coroutine once it completes.
+ * @param handle    The suspended coroutine.
+ */
+void ArchiveAwaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    reader_.read(index_, archive_, [this, handle](std::exception_ptr error, RSBuffer data) {
+        error_  = std::move(error);
+        result_ = std::move(data);
+        handle.resume();
+    });
+}
+
+/**
+ * Gets the result of the read.
+ * @return  The decompressed archive data.
+ */
+RSBuffer ArchiveAwaitable::await_resume()
+{
+    if (error_)
+        std::rethrow_exception(error_);
+    return std::move(result_);
+}
+
+/**
+ * Creates an asynchronous reader for a filesystem.
+ * @param fs            The filesystem to read from.
+ * @param threads       The number of worker threads, or 0 to use the number of hardware threads.
+ * @param queueDepth    The maximum number of sector reads submitted to io_uring at once.
+ */
+AsyncReader::AsyncReader(RSFileSystem& fs, size_t threads, size_t queueDepth)
+    : fs_(fs),
+      sectors_(dynamic_cast<SectorStore*>(&fs.store())),
+      generation_(sectors_ ? sectors_->generation() : 0),
+      pool_(workerCount(threads)),
+      ring_(createRing(sectors_, queueDepth))
+{
+}
+
+/**
+ * Waits for all outstanding reads to complete, and destroys this reader.
+ */
+AsyncReader::~AsyncReader()
+{
+    ring_.reset();
+    pool_.join();
+}
+
+/**
+ * Reads and decompresses an archive, invoking a callback once it has completed. The callback is invoked on
+ * a worker thread, and must not throw.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param callback  The callback.
+ */
+void AsyncReader::read(size_t index, size_t archive, Callback callback)
+{
+    // Without io_uring, the whole read is performed on the thread pool
+    if (!ring_)
+    {
+        boost::asio::post(pool_, [this, index, archive, callback = std::move(callback)] {
+            RSBuffer decompressed(0);
+            try
+            {
+                auto& file   = fs_.getIndex(index);
+                auto data    = file.readArchive(archive);
+                decompressed = decompressArchive(file, archive, data);
+            }
+            catch (...)
+            {
+                callback(std::current_exception(), RSBuffer(0));
+                return;
+            }
+            callback(nullptr, std::move(decompressed));
+        });
+        return;
+    }
+
+    // The index entry is small and almost always in the page cache, so it is read synchronously
+    IndexEntry entry;
+    try
+    {
+        entry = sectors_->entry(index, archive);
+
+        // The entry may already come from a reloaded index file, so the sectors must come from its data file
+        refreshRing();
+    }
+    catch (...)
+    {
+        boost::asio::post(pool_, [callback = std::move(callback), error = std::current_exception()] {
+            callback(error, RSBuffer(0));
+        });
+        return;
+    }
+
+    auto onRead = [this, index, archive, callback = std::move(callback)](auto error, RSBuffer data) {
+        if (error)
+        {
+            boost::asio::post(pool_, [callback, error] { callback(error, RSBuffer(0)); });
+            return;
+        }
+        decompress(index, archive, std::move(data), callback);
+    };
+    ring_->read(index, archive, entry, std::move(onRead));
+}
+
+/**
+ * Reads and decompresses an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The future decompressed archive data.
+ */
+std::future<RSBuffer> AsyncReader::read(size_t index, size_t archive)
+{
+    auto promise = std::make_shared<std::promise<RSBuffer>>();
+    auto future  = promise->get_future();
+    read(index, archive, [promise](std::exception_ptr error, RSBuffer data) {
+        if (error)
+            promise->set_exception(error);
+        else
+            promise->set_value(std::move(data));
+    });
+    return future;
+}
+
+/**
+ * Deciphers and decompresses a compressed archive on the thread pool, and passes it to a callback.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param data      The compressed archive data.
+ * @param callback  The callback.
+ */
+void AsyncReader::decompress(size_t index, size_t archive, RSBuffer data, Callback callback)
+{
+    boost::asio::post(pool_, [this, index, archive, data = std::move(data), callback = std::move(callback)]() mutable {
+        RSBuffer decompressed(0);
+        try
+        {
+            decompressed = decompressArchive(fs_.getIndex(index), archive, data);
+        }
+        catch (...)
+        {
+            callback(std::current_exception(), RSBuffer(0));
+            return;
+        }
+        callback(nullptr, std::move(decompressed));
+    });
+}
+
+/**
+ * Reopens the data file of the io_uring backend if the store has reopened or grown its own since.
+ */
+void AsyncReader::refreshRing()
+{
+    if (sectors_->generation() == generation_.load(std::memory_order_acquire))
+        return;
+
+    // The generation is read before the file is opened, so the backend's file is never older than it
+    std::lock_guard lock(refreshMutex_);
+    auto generation = sectors_->generation();
+    if (generation == generation_.load(std::memory_order_relaxed))
+        return;
+
+    ring_->reopen(sectors_->dataPath());
+    generation_.store(generation, std::memory_order_release);
+}
@@ -0,0 +1,389 @@
+#include "async/IoUringBackend.hpp"
+
+#ifdef RSFS_HAVE_IO_URING
+#include "util/Advise.hpp"
+
+#include <rsfs/jag/DataFile.hpp>
+#include <rsfs/metrics/Metrics.hpp>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace rsfs;
+
+#ifdef RSFS_HAVE_IO_URING
+/**
+ * The state of a sector chain being read.
+ */
+struct IoUringBackend::Request
+{
+    /**
+     * The index id.
+     */
+    size_t index;
+
+    /**
+     * The archive id.
+     */
+    size_t archive;
+
+    /**
+     * The total length of the archive.
+     */
+    size_t length;
+
+    /**
+     * The sector currently being read.
+     */
+    uint32_t sector;
+
+    /**
+     * The first sector of the run that was last requested ahead of the chain.
+     */
+    uint32_t requestedStart{ 0 };
+
+    /**
+     * The end of the run that was last requested ahead of the chain.
+     */
+    uint32_t requestedEnd{ 0 };
+
+    /**
+     * The data file that the chain is read from.
+     */
+    std::shared_ptr<const DataFileHandle> file;
+
+    /**
+     * The function invoked once the chain has been read.
+     */
+    Completion done;
+
+    /**
+     * The archive data read so far.
+     */
+    RSBuffer data{ 0 };
+
+    /**
+     * The time at which the current sector read was submitted.
+     */
+    std::chrono::steady_clock::time_point submitted;
+
+    /**
+     * The buffer that the current sector is read into.
+     */
+    char sectorData[SECTOR_SIZE];
+};
+#endif
+
+/**
+ * Creates an io_uring backend for a data file.
+ * @param path          The path to the data file.
+ * @param queueDepth    The maximum number of sector reads in flight.
+ * @param hints         How the data file will be read.
+ * @return              The backend, or null if io_uring is unavailable.
+ */
+std::unique_ptr<IoUringBackend> IoUringBackend::create([[maybe_unused]] const std::string& path,
+                                                       [[maybe_unused]] size_t queueDepth,
+                                                       [[maybe_unused]] IoHints hints)
+{
+#ifdef RSFS_HAVE_IO_URING
+    auto file = open(path, hints);
+    if (!file)
+        return nullptr;
+
+    try
+    {
+        return std::unique_ptr<IoUringBackend>(new IoUringBackend(std::move(file), queueDepth, hints));
+    }
+    catch (const std::exception& e)
+    {
+        LOG(WARNING) << "io_uring is unavailable, falling back to a thread pool: " << e.what();
+        return nullptr;
+    }
+#else
+    return nullptr;
+#endif
+}
+
+#ifdef RSFS_HAVE_IO_URING
+/**
+ * Closes the data file.
+ */
+IoUringBackend::DataFileHandle::~DataFileHandle()
+{
+    ::close(fd);
+}
+
+/**
+ * Opens a data file and applies the hints to it.
+ * @param path  The path to the data file.
+ * @param hints How the data file will be read.
+ * @return      The open file, or null if it couldn't be opened.
+ */
+std::shared_ptr<const IoUringBackend::DataFileHandle> IoUringBackend::open(const std::string& path, const IoHints& hints)
+{
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+
+    adviseFile(fd, hints.pattern);
+    auto length = ::lseek(fd, 0, SEEK_END);
+    return std::shared_ptr<const DataFileHandle>(new DataFileHandle{ fd, static_cast<size_t>(length) });
+}
+
+/**
+ * Initialises the backend with an initialised ring.
+ * @param file          The data file.
+ * @param queueDepth    The maximum number of sector reads in flight.
+ * @param hints         How the data file will be read.
+ */
+IoUringBackend::IoUringBackend(std::shared_ptr<const DataFileHandle> file, size_t queueDepth, IoHints hints)
+    : file_(std::move(file)), queueDepth_(queueDepth), hints_(hints)
+{
+    if (io_uring_queue_init(queueDepth_, &ring_, 0) < 0)
+        throw std::runtime_error("Unable to initialise io_uring");
+    reaper_ = std::thread(&IoUringBackend::reap, this);
+}
+#endif
+
+/**
+ * Waits for all reads in flight to complete, and releases the ring.
+ */
+IoUringBackend::~IoUringBackend()
+{
+#ifdef RSFS_HAVE_IO_URING
+    stopping_ = true;
+    {
+        std::lock_guard lock(mutex_);
+        submitLocked(nullptr);
+    }
+
+    reaper_.join();
+    io_uring_queue_exit(&ring_);
+#endif
+}
+
+/**
+ * Reads the sector chain of an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param entry     The index entry of the archive.
+ * @param done      The function invoked with the compressed archive data.
+ */
+void IoUringBackend::read([[maybe_unused]] size_t index, [[maybe_unused]] size_t archive,
+                          [[maybe_unused]] IndexEntry entry, [[maybe_unused]] Completion done)
+{
+#ifdef RSFS_HAVE_IO_URING
+    std::shared_ptr<const DataFileHandle> file;
+    {
+        std::lock_guard lock(mutex_);
+        file = file_;
+    }
+
+    // Validate the sector input
+    if (entry.sector <= 0 || file->length / SECTOR_SIZE < entry.sector)
+    {
+        done(std::make_exception_ptr(std::runtime_error("Sector out of bounds")), RSBuffer(0));
+        return;
+    }
+
+    auto* request = new Request{ .index   = index,
+                                 .archive = archive,
+                                 .length  = entry.length,
+                                 .sector  = entry.sector,
+                                 .file    = std::move(file) };
+    request->done = std::move(done);
+    request->data = RSBuffer(entry.length);
+    readAhead(request);
+    submit(request);
+#endif
+}
+
+/**
+ * Reopens the data file.
+ * @param path  The path to the data file.
+ */
+void IoUringBackend::reopen([[maybe_unused]] const std::string& path)
+{
+#ifdef RSFS_HAVE_IO_URING
+    auto file = open(path, hints_);
+    if (!file)
+        throw std::runtime_error("Unable to open data file");
+
+    std::lock_guard lock(mutex_);
+    file_ = std::move(file);
+#endif
+}
+
+#ifdef RSFS_HAVE_IO_URING
+/**
+ * Submits the read of the current sector of a request, or queues it if the ring is full.
+ * @param request   The request.
+ */
+void IoUringBackend::submit(Request* request)
+{
+    std::lock_guard lock(mutex_);
+    if (inFlight_ >= queueDepth_)
+    {
+        pending_.push_back(request);
+        return;
+    }
+    submitLocked(request);
+}
+
+/**
+ * Submits the read of the current sector of a request. The submission mutex must be held.
+ * @param request   The request, or null to submit a wake-up.
+ */
+void IoUringBackend::submitLocked(Request* request)
+{
+    // Flush the submission queue if it is full
+    auto* sqe = io_uring_get_sqe(&ring_);
+    while (!sqe)
+    {
+        io_uring_submit(&ring_);
+        sqe = io_uring_get_sqe(&ring_);
+    }
+
+    if (request)
+    {
+        auto offset = static_cast<uint64_t>(request->sector) * SECTOR_SIZE;
+        io_uring_prep_read(sqe, request->file->fd, request->sectorData, SECTOR_SIZE, offset);
+        request->submitted = std::chrono::steady_clock::now();
+        ++inFlight_;
+    }
+    else
+    {
+        io_uring_prep_nop(sqe);
+    }
+
+    io_uring_sqe_set_data(sqe, request);
+    io_uring_submit(&ring_);
+}
+
+/**
+ * Requests the sectors ahead of the current sector of a request, if the chain has left the run that was requested
+ * last.
+ * @param request   The request.
+ */
+void IoUringBackend::readAhead(Request* request)
+{
+    if (hints_.readaheadSectors == 0)
+        return;
+
+    // Assume that the chain continues contiguously, as the data file does when reading without io_uring
+    auto headerSize = request->archive > 0xFFFF ? LARGE_HEADER_SIZE : SMALL_HEADER_SIZE;
+    auto dataSize   = SECTOR_SIZE - headerSize;
+    auto remaining  = (request->length - request->data.getSize() + dataSize - 1) / dataSize;
+    if (remaining <= 1 || (request->sector >= request->requestedStart && request->sector < request->requestedEnd))
+        return;
+
+    request->requestedStart = request->sector;
+    request->requestedEnd   = request->sector + std::min(hints_.readaheadSectors, remaining);
+    requestRange(request->file->fd, static_cast<size_t>(request->requestedStart) * SECTOR_SIZE,
+                 static_cast<size_t>(request->requestedEnd - request->requestedStart) * SECTOR_SIZE);
+}
+
+/**
+ * Handles a completed sector read.
+ * @param request   The request.
+ * @param result    The result of the read.
+ */
+void IoUringBackend::complete(Request* request, int result)
+{
+    std::exception_ptr error;
+    if (result != SECTOR_SIZE)
+    {
+        error = std::make_exception_ptr(std::runtime_error(result < 0 ? "Read failed" : "Short read"));
+    }
+    else
+    {
+        Metrics::recordSectorRead(std::chrono::steady_clock::now() - request->submitted);
+        Metrics::increment(request->index, SECTORS_READ);
+
+        // If we should read this as a large sector
+        auto largeSector = request->archive > 0xFFFF;
+        auto headerSize  = largeSector ? LARGE_HEADER_SIZE : SMALL_HEADER_SIZE;
+        auto dataSize    = SECTOR_SIZE - headerSize;
+
+        // Write the bytes into the archive buffer
+        auto header    = DataFile::decodeHeader(request->sectorData, largeSector);
+        auto remaining = request->length - request->data.getSize();
+        request->data.writeBytes(&request->sectorData[headerSize], std::min<size_t>(dataSize, remaining));
+
+        // Continue along the chain if there is more to read
+        if (request->data.getSize() < request->length)
+        {
+            request->sector = header.nextSector;
+            if (request->sector <= 0 || request->file->length / SECTOR_SIZE < request->sector)
+            {
+                error = std::make_exception_ptr(std::runtime_error("Sector out of bounds"));
+            }
+            else
+            {
+                readAhead(request);
+
+                std::lock_guard lock(mutex_);
+                --inFlight_;
+                submitLocked(request);
+                return;
+            }
+        }
+    }
+
+    // The chain is finished, so make room for any reads waiting for the ring
+    {
+        std::lock_guard lock(mutex_);
+        --inFlight_;
+        while (!pending_.empty() && inFlight_ < queueDepth_)
+        {
+            auto* next = pending_.front();
+            pending_.pop_front();
+            submitLocked(next);
+        }
+    }
+
+    std::unique_ptr<Request> finished(request);
+    if (error)
+    {
+        finished->done(error, RSBuffer(0));
+        return;
+    }
+
+    Metrics::increment(finished->index, ARCHIVES_READ);
+    Metrics::increment(finished->index, BYTES_READ, finished->length);
+    finished->done(nullptr, std::move(finished->data));
+}
+
+/**
+ * Reaps completions until the backend is stopped and no reads are in flight.
+ */
+void IoUringBackend::reap()
+{
+    while (true)
+    {
+        io_uring_cqe* cqe;
+        auto result = io_uring_wait_cqe(&ring_, &cqe);
+        if (result == -EINTR)
+            continue;
+        if (result < 0)
+            LOG(FATAL) << "Unable to wait for io_uring completion: " << result;
+
+        auto* request = static_cast<Request*>(io_uring_cqe_get_data(cqe));
+        auto res      = cqe->res;
+        io_uring_cqe_seen(&ring_, cqe);
+
+        if (request)
+            complete(request, res);
+
+        std::lock_guard lock(mutex_);
+        if (stopping_ && inFlight_ == 0 && pending_.empty())
+            break;
+    }
+}
+#endif
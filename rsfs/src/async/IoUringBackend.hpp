@@ -0,0 +1,186 @@
+#pragma once
+
+#include <rsfs/io/RSBuffer.hpp>
+#include <rsfs/jag/IndexEntry.hpp>
+#include <rsfs/jag/IoHints.hpp>
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifdef RSFS_HAVE_IO_URING
+#include <liburing.h>
+#endif
+
+namespace rsfs
+{
+    /**
+     * Reads sector chains from the data file through io_uring. Each read is a small state machine that submits
+     * one sector at a time, as the location of the next sector is only known once the current one has been read.
+     * Completions are reaped by a single thread, which submits the next sector of each chain.
+     */
+    class IoUringBackend
+    {
+    public:
+        /**
+         * The function invoked when a sector chain has been read.
+         */
+        using Completion = std::function<void(std::exception_ptr error, RSBuffer data)>;
+
+        /**
+         * Creates an io_uring backend for a data file.
+         * @param path          The path to the data file.
+         * @param queueDepth    The maximum number of sector reads in flight.
+         * @param hints         How the data file will be read.
+         * @return              The backend, or null if io_uring is unavailable.
+         */
+        static std::unique_ptr<IoUringBackend> create(const std::string& path, size_t queueDepth, IoHints hints = {});
+
+        /**
+         * Waits for all reads in flight to complete, and releases the ring.
+         */
+        ~IoUringBackend();
+
+        /**
+         * Reads the sector chain of an archive.
+         * @param index     The index id.
+         * @param archive   The archive id.
+         * @param entry     The index entry of the archive.
+         * @param done      The function invoked with the compressed archive data.
+         */
+        void read(size_t index, size_t archive, IndexEntry entry, Completion done);
+
+        /**
+         * Reopens the data file, such as after it has been replaced or grown on disk. Chains that are being read
+         * finish reading from the file they started in.
+         * @param path  The path to the data file.
+         */
+        void reopen(const std::string& path);
+
+    private:
+#ifdef RSFS_HAVE_IO_URING
+        /**
+         * The state of a sector chain being read.
+         */
+        struct Request;
+
+        /**
+         * An open data file, which stays open until the last chain that reads from it has finished.
+         */
+        struct DataFileHandle
+        {
+            /**
+             * Closes the data file.
+             */
+            ~DataFileHandle();
+
+            /**
+             * The file descriptor.
+             */
+            int fd;
+
+            /**
+             * The length of the data file.
+             */
+            size_t length;
+        };
+
+        /**
+         * Opens a data file and applies the hints to it.
+         * @param path  The path to the data file.
+         * @param hints How the data file will be read.
+         * @return      The open file, or null if it couldn't be opened.
+         */
+        static std::shared_ptr<const DataFileHandle> open(const std::string& path, const IoHints& hints);
+
+        /**
+         * Initialises the backend with an initialised ring.
+         * @param file          The data file.
+         * @param queueDepth    The maximum number of sector reads in flight.
+         * @param hints         How the data file will be read.
+         */
+        IoUringBackend(std::shared_ptr<const DataFileHandle> file, size_t queueDepth, IoHints hints);
+
+        /**
+         * Requests the sectors ahead of the current sector of a request, if the chain has left the run that was
+         * requested last, so that they are read while the current sector is processed.
+         * @param request   The request.
+         */
+        void readAhead(Request* request);
+
+        /**
+         * Submits the read of the current sector of a request, or queues it if the ring is full.
+         * @param request   The request.
+         */
+        void submit(Request* request);
+
+        /**
+         * Submits the read of the current sector of a request. The submission mutex must be held.
+         * @param request   The request, or null to submit a wake-up.
+         */
+        void submitLocked(Request* request);
+
+        /**
+         * Handles a completed sector read.
+         * @param request   The request.
+         * @param result    The result of the read.
+         */
+        void complete(Request* request, int result);
+
+        /**
+         * Reaps completions until the backend is stopped and no reads are in flight.
+         */
+        void reap();
+
+        /**
+         * The ring.
+         */
+        io_uring ring_{};
+
+        /**
+         * The data file that new chains are read from, guarded by the submission mutex.
+         */
+        std::shared_ptr<const DataFileHandle> file_;
+
+        /**
+         * The maximum number of sector reads in flight.
+         */
+        size_t queueDepth_;
+
+        /**
+         * How the data file is read.
+         */
+        IoHints hints_;
+
+        /**
+         * The mutex guarding submissions.
+         */
+        std::mutex mutex_;
+
+        /**
+         * The number of sector reads in flight.
+         */
+        size_t inFlight_{ 0 };
+
+        /**
+         * The requests waiting for space in the ring.
+         */
+        std::deque<Request*> pending_;
+
+        /**
+         * If the backend is shutting down.
+         */
+        std::atomic<bool> stopping_{ false };
+
+        /**
+         * The thread reaping completions.
+         */
+        std::thread reaper_;
+#endif
+    };
+}
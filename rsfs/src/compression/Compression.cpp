@@ -1,12 +1,20 @@
+#include "util/BigEndian.hpp"
+#include "util/Parallel.hpp"
+
 #include <rsfs/compression/Compression.hpp>
 #include <rsfs/compression/CompressionType.hpp>
+#include <rsfs/metrics/Metrics.hpp>
+#include <bzlib.h>
+#include <lzma.h>
 #include <zlib.h>
 
-#include <boost/crc.hpp>
-#include <boost/iostreams/copy.hpp>
-#include <boost/iostreams/filter/bzip2.hpp>
-#include <boost/iostreams/filter/zlib.hpp>
-#include <boost/iostreams/filtering_streambuf.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
 
 using namespace rsfs;
 
@@ -24,6 +32,310 @@ constexpr const auto COMPRESSION_HEADER_LENGTH = 4;
  */
 constexpr const auto BZIP2_HEADER = "BZh1";
 
+/**
+ * The BZIP2 block size, in units of 100k, implied by the header.
+ */
+constexpr const auto BZIP2_BLOCK_SIZE = 1;
+
+/**
+ * The length of the LZMA properties that precede an LZMA payload: the lc/lp/pb byte and the dictionary size.
+ */
+constexpr const auto LZMA_PROPERTIES_LENGTH = 5;
+
+/**
+ * The largest decompressed length that a container may declare. The largest archives in real caches are a few
+ * megabytes, so anything beyond this is a corrupt header rather than data worth allocating for.
+ */
+constexpr const auto MAX_DECOMPRESSED_LENGTH = 256 * 1024 * 1024;
+
+/**
+ * The names of the compression types, indexed by type.
+ */
+constexpr const std::array<const char*, COMPRESSION_TYPES> TYPE_NAMES = { "none", "bzip2", "gzip", "lzma" };
+
+namespace
+{
+    /**
+     * A GZIP encoder that is kept for the lifetime of a thread, so that its state is only allocated once.
+     */
+    struct GzipEncoder
+    {
+        GzipEncoder()
+        {
+            if (deflateInit2(&stream, level, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                throw std::runtime_error("Unable to initialise the GZIP encoder");
+        }
+
+        ~GzipEncoder()
+        {
+            deflateEnd(&stream);
+        }
+
+        GzipEncoder(const GzipEncoder&) = delete;
+        GzipEncoder& operator=(const GzipEncoder&) = delete;
+
+        z_stream stream{};
+        int level{ DEFAULT_COMPRESSION_LEVEL };
+    };
+
+    /**
+     * A GZIP decoder that is kept for the lifetime of a thread, so that its state is only allocated once.
+     */
+    struct GzipDecoder
+    {
+        GzipDecoder()
+        {
+            if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+                throw std::runtime_error("Unable to initialise the GZIP decoder");
+        }
+
+        ~GzipDecoder()
+        {
+            inflateEnd(&stream);
+        }
+
+        GzipDecoder(const GzipDecoder&) = delete;
+        GzipDecoder& operator=(const GzipDecoder&) = delete;
+
+        z_stream stream{};
+    };
+
+    /**
+     * An LZMA stream that is kept for the lifetime of a thread. liblzma reuses the stream's allocations when it
+     * is reinitialised with the same filter.
+     */
+    struct LzmaStream
+    {
+        LzmaStream() = default;
+
+        ~LzmaStream()
+        {
+            lzma_end(&stream);
+        }
+
+        LzmaStream(const LzmaStream&) = delete;
+        LzmaStream& operator=(const LzmaStream&) = delete;
+
+        lzma_stream stream = LZMA_STREAM_INIT;
+    };
+
+    /**
+     * Compresses data with GZIP, using this thread's encoder.
+     * @param data  The data to compress.
+     * @param level The compression level.
+     * @param out   The container, which the payload is written to after the header.
+     * @return      The length of the payload.
+     */
+    size_t deflateGzip(const RSBuffer& data, int level, RSBuffer& out)
+    {
+        thread_local GzipEncoder encoder;
+        auto& stream = encoder.stream;
+        if (deflateReset(&stream) != Z_OK)
+            throw std::runtime_error("Unable to reset the GZIP encoder");
+
+        // The parameters can only be changed cheaply before any data has been compressed
+        if (encoder.level != level)
+        {
+            if (deflateParams(&stream, level, Z_DEFAULT_STRATEGY) != Z_OK)
+                throw std::runtime_error("Invalid GZIP compression level");
+            encoder.level = level;
+        }
+
+        auto bound = deflateBound(&stream, data.getSize());
+        out.resize(COMPRESSED_HEADER_LENGTH + bound);
+
+        stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data.begin()));
+        stream.avail_in  = data.getSize();
+        stream.next_out  = reinterpret_cast<Bytef*>(out.data() + COMPRESSED_HEADER_LENGTH);
+        stream.avail_out = bound;
+        if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+            throw std::runtime_error("Unable to compress with GZIP");
+        return stream.total_out;
+    }
+
+    /**
+     * Compresses data with BZIP2.
+     * @param data  The data to compress.
+     * @param out   The container, which the payload is written to after the header.
+     * @return      The length of the payload, without the BZIP2 header.
+     */
+    size_t deflateBzip2(const RSBuffer& data, RSBuffer& out)
+    {
+        // The payload is written so that its header overlaps the end of the container header, which is written
+        // over it afterwards, avoiding a copy to strip the header
+        auto offset = COMPRESSED_HEADER_LENGTH - COMPRESSION_HEADER_LENGTH;
+        auto bound  = static_cast<unsigned int>(data.getSize() + data.getSize() / 100 + 600);
+        out.resize(offset + bound);
+
+        // libbz2 rejects the null source of an empty buffer
+        char empty  = 0;
+        auto source = data.getSize() > 0 ? const_cast<char*>(data.begin()) : &empty;
+
+        auto result =
+            BZ2_bzBuffToBuffCompress(out.data() + offset, &bound, source, data.getSize(), BZIP2_BLOCK_SIZE, 0, 0);
+        if (result != BZ_OK || std::memcmp(out.data() + offset, BZIP2_HEADER, COMPRESSION_HEADER_LENGTH) != 0)
+            throw std::runtime_error("Unable to compress with BZIP2");
+        return bound - COMPRESSION_HEADER_LENGTH;
+    }
+
+    /**
+     * Compresses data with LZMA, using this thread's encoder. The payload is the LZMA properties followed by a
+     * raw LZMA1 stream without an end marker, as the decompressed length is stored in the container header.
+     * @param data  The data to compress.
+     * @param level The LZMA preset.
+     * @param out   The container, which the payload is written to after the header.
+     * @return      The length of the payload.
+     */
+    size_t deflateLzma(const RSBuffer& data, int level, RSBuffer& out)
+    {
+        lzma_options_lzma options;
+        if (lzma_lzma_preset(&options, level))
+            throw std::runtime_error("Invalid LZMA compression level");
+
+        // A dictionary larger than the data only costs the decoder memory
+        options.dict_size = std::clamp<uint32_t>(data.getSize(), LZMA_DICT_SIZE_MIN, options.dict_size);
+        options.ext_flags = 0;
+
+        std::array<lzma_filter, 2> filters{ { { LZMA_FILTER_LZMA1EXT, &options }, { LZMA_VLI_UNKNOWN, nullptr } } };
+
+        // Raw LZMA1 has no stored blocks, so incompressible data expands slightly
+        auto start = COMPRESSED_HEADER_LENGTH + LZMA_PROPERTIES_LENGTH;
+        auto bound = data.getSize() + data.getSize() / 32 + 1024;
+        out.resize(start + bound);
+        auto* properties = reinterpret_cast<uint8_t*>(out.data() + COMPRESSED_HEADER_LENGTH);
+        if (lzma_properties_encode(filters.data(), properties) != LZMA_OK)
+            throw std::runtime_error("Unable to encode the LZMA properties");
+
+        thread_local LzmaStream encoder;
+        auto& stream = encoder.stream;
+        if (lzma_raw_encoder(&stream, filters.data()) != LZMA_OK)
+            throw std::runtime_error("Unable to initialise the LZMA encoder");
+
+        stream.next_in   = reinterpret_cast<const uint8_t*>(data.begin());
+        stream.avail_in  = data.getSize();
+        stream.next_out  = reinterpret_cast<uint8_t*>(out.data() + start);
+        stream.avail_out = bound;
+        auto result = lzma_code(&stream, LZMA_FINISH);
+        while (result == LZMA_OK && stream.avail_out == 0)
+        {
+            // Grow the output if the estimate was too small
+            out.resize(out.getSize() + bound);
+            stream.next_out  = reinterpret_cast<uint8_t*>(out.data() + start + stream.total_out);
+            stream.avail_out = bound;
+            result           = lzma_code(&stream, LZMA_FINISH);
+        }
+
+        if (result != LZMA_STREAM_END)
+            throw std::runtime_error("Unable to compress with LZMA");
+        return LZMA_PROPERTIES_LENGTH + stream.total_out;
+    }
+
+    /**
+     * Decompresses a GZIP payload straight into a buffer of the decompressed length, using this thread's decoder.
+     * @param payload           The payload.
+     * @param compressedSize    The length of the payload.
+     * @param decompressedSize  The length of the decompressed data.
+     * @return                  The decompressed data.
+     */
+    RSBuffer inflateGzip(const char* payload, size_t compressedSize, size_t decompressedSize)
+    {
+        thread_local GzipDecoder decoder;
+        auto& stream = decoder.stream;
+        if (inflateReset(&stream) != Z_OK)
+            throw std::runtime_error("Unable to reset the GZIP decoder");
+
+        RSBuffer decompressed(0);
+        decompressed.resize(decompressedSize);
+        stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(payload));
+        stream.avail_in  = compressedSize;
+        stream.next_out  = reinterpret_cast<Bytef*>(decompressed.data());
+        stream.avail_out = decompressedSize;
+        if (inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.total_out != decompressedSize)
+            throw std::runtime_error("Unable to decompress GZIP payload");
+        return decompressed;
+    }
+
+    /**
+     * Decompresses a BZIP2 payload straight into a buffer of the decompressed length. The header that containers
+     * omit is fed to the decoder before the payload, so the payload doesn't have to be copied.
+     * @param payload           The payload, without the BZIP2 header.
+     * @param compressedSize    The length of the payload.
+     * @param decompressedSize  The length of the decompressed data.
+     * @return                  The decompressed data.
+     */
+    RSBuffer inflateBzip2(const char* payload, size_t compressedSize, size_t decompressedSize)
+    {
+        bz_stream stream{};
+        if (BZ2_bzDecompressInit(&stream, 0, 0) != BZ_OK)
+            throw std::runtime_error("Unable to initialise the BZIP2 decoder");
+        std::unique_ptr<bz_stream, decltype(&BZ2_bzDecompressEnd)> guard(&stream, &BZ2_bzDecompressEnd);
+
+        RSBuffer decompressed(0);
+        decompressed.resize(decompressedSize);
+        stream.next_out  = decompressed.data();
+        stream.avail_out = decompressedSize;
+
+        // The decoder consumes all of its input before returning, unless the stream ends
+        stream.next_in  = const_cast<char*>(BZIP2_HEADER);
+        stream.avail_in = COMPRESSION_HEADER_LENGTH;
+        auto result     = BZ2_bzDecompress(&stream);
+        if (result == BZ_OK)
+        {
+            stream.next_in  = const_cast<char*>(payload);
+            stream.avail_in = compressedSize;
+            result          = BZ2_bzDecompress(&stream);
+        }
+
+        auto total = (static_cast<uint64_t>(stream.total_out_hi32) << 32) | stream.total_out_lo32;
+        if (result != BZ_STREAM_END || total != decompressedSize)
+            throw std::runtime_error("Unable to decompress BZIP2 payload");
+        return decompressed;
+    }
+
+    /**
+     * Decompresses an LZMA payload straight into a buffer of the decompressed length, using this thread's
+     * decoder.
+     * @param payload           The payload, starting with the LZMA properties.
+     * @param compressedSize    The length of the payload.
+     * @param decompressedSize  The length of the decompressed data.
+     * @return                  The decompressed data.
+     */
+    RSBuffer inflateLzma(const char* payload, size_t compressedSize, size_t decompressedSize)
+    {
+        if (compressedSize < LZMA_PROPERTIES_LENGTH)
+            throw std::runtime_error("LZMA payload is too short");
+
+        auto properties = reinterpret_cast<const uint8_t*>(payload);
+        lzma_filter filter{ LZMA_FILTER_LZMA1, nullptr };
+        if (lzma_properties_decode(&filter, nullptr, properties, LZMA_PROPERTIES_LENGTH) != LZMA_OK)
+            throw std::runtime_error("Invalid LZMA properties");
+
+        // The decompressed length is known, so the stream may or may not have an end marker
+        std::unique_ptr<lzma_options_lzma, decltype(&free)> options(static_cast<lzma_options_lzma*>(filter.options),
+                                                                   &free);
+        options->ext_flags     = LZMA_LZMA1EXT_ALLOW_EOPM;
+        options->ext_size_low  = static_cast<uint32_t>(decompressedSize);
+        options->ext_size_high = static_cast<uint32_t>(static_cast<uint64_t>(decompressedSize) >> 32);
+
+        std::array<lzma_filter, 2> filters{ { { LZMA_FILTER_LZMA1EXT, options.get() }, { LZMA_VLI_UNKNOWN, nullptr } } };
+
+        thread_local LzmaStream decoder;
+        auto& stream = decoder.stream;
+        if (lzma_raw_decoder(&stream, filters.data()) != LZMA_OK)
+            throw std::runtime_error("Unable to initialise the LZMA decoder");
+
+        RSBuffer decompressed(0);
+        decompressed.resize(decompressedSize);
+        stream.next_in   = reinterpret_cast<const uint8_t*>(payload + LZMA_PROPERTIES_LENGTH);
+        stream.avail_in  = compressedSize - LZMA_PROPERTIES_LENGTH;
+        stream.next_out  = reinterpret_cast<uint8_t*>(decompressed.data());
+        stream.avail_out = decompressedSize;
+        if (lzma_code(&stream, LZMA_FINISH) != LZMA_STREAM_END || stream.total_out != decompressedSize)
+            throw std::runtime_error("Unable to decompress LZMA payload");
+        return decompressed;
+    }
+}
+
 /**
  * Decompresses a buffer.
  * @param buf   The compressed buffer.
@@ -31,67 +343,162 @@ constexpr const auto BZIP2_HEADER = "BZh1";
  */
 RSBuffer Compression::decompress(RSBuffer& buf)
 {
-    using namespace std;
-    using namespace boost::iostreams;
+    auto position     = buf.getSize() - buf.getRemaining();
+    auto container    = std::span(buf.begin() + position, buf.getRemaining());
+    auto decompressed = decompress(container);
+
+    // Leave the reader after the payload, where the revision starts if the container has one
+    static_cast<void>(buf.readRange(containerHeader(container.data(), container.size()).payloadEnd()));
+    return decompressed;
+}
+
+/**
+ * Decompresses a container in place, without copying it into a buffer first.
+ * @param container The compressed container.
+ * @return          The decompressed data.
+ */
+RSBuffer Compression::decompress(std::span<const char> container)
+{
+    auto start          = std::chrono::steady_clock::now();
+    auto header         = containerHeader(container.data(), container.size());
+    auto type           = header.type;
+    auto compressedSize = header.compressedLength;
+    if (type >= COMPRESSION_TYPES)
+        throw std::runtime_error("Unknown compression type");
 
-    auto type           = static_cast<CompressionType>(buf.readByte());
-    auto compressedSize = buf.readInt();
+    // Every type, including uncompressed data, must have its whole payload in the container
+    if (container.size() < header.headerLength() || compressedSize > container.size() - header.headerLength())
+        throw std::runtime_error("Container is truncated");
 
     // If the compression type is nothing, return the data block
     if (type == NONE)
     {
-        auto range = buf.readRange(compressedSize);
-        return RSBuffer(range.begin(), compressedSize);
+        RSBuffer decompressed(container.data() + CONTAINER_HEADER_LENGTH, compressedSize);
+        Metrics::recordDecompression(type, std::chrono::steady_clock::now() - start);
+        return decompressed;
     }
 
     // The length of the decompressed data
-    auto decompressedSize = buf.readInt();
+    auto decompressedSize = decodeInt(container.data() + CONTAINER_HEADER_LENGTH);
+    if (decompressedSize > MAX_DECOMPRESSED_LENGTH)
+        throw std::runtime_error("Decompressed length is too large");
 
-    // The current checksum of the data
-    boost::crc_32_type checksum;
+    // Every type is decoded straight from the container into a buffer of the decompressed length
+    auto payload = container.data() + COMPRESSED_HEADER_LENGTH;
+    RSBuffer decompressed;
+    if (type == BZIP2)
+        decompressed = inflateBzip2(payload, compressedSize, decompressedSize);
+    else if (type == GZIP)
+        decompressed = inflateGzip(payload, compressedSize, decompressedSize);
+    else
+        decompressed = inflateLzma(payload, compressedSize, decompressedSize);
 
-    // The compressed data
-    RSBuffer compressed(compressedSize + COMPRESSION_HEADER_LENGTH);
+    Metrics::recordDecompression(type, std::chrono::steady_clock::now() - start);
+    return decompressed;
+}
 
-    // Write the BZIP2 header if applicable
-    if (type == BZIP2)
+/**
+ * Compresses data into a container that decompress() reads back.
+ * @param data      The data to compress.
+ * @param type      The type of compression.
+ * @param revision  The revision to append to the container, if any.
+ * @param level     The compression level, from 1 to 9.
+ * @return          The container.
+ */
+RSBuffer Compression::compress(const RSBuffer& data, CompressionType type, std::optional<uint16_t> revision, int level)
+{
+    RSBuffer out(0);
+    size_t length;
+
+    switch (type)
     {
-        compressed.writeBytes(BZIP2_HEADER, 4);
+        case NONE:
+            length = data.getSize();
+            out.resize(CONTAINER_HEADER_LENGTH + length);
+            std::memcpy(out.data() + CONTAINER_HEADER_LENGTH, data.begin(), length);
+            break;
+        case BZIP2:
+            length = deflateBzip2(data, out);
+            break;
+        case GZIP:
+            length = deflateGzip(data, level, out);
+            break;
+        case LZMA:
+            length = deflateLzma(data, level, out);
+            break;
+        default:
+            throw std::runtime_error("Unsupported compression type");
     }
 
-    // Write the bytes to decompress
-    compressed.writeBytes(buf.readRange(compressedSize));
+    // Write the header, and trim the buffer to the payload
+    out.data()[0] = static_cast<char>(type);
+    encodeInt(out.data() + 1, length);
+    if (type != NONE)
+        encodeInt(out.data() + CONTAINER_HEADER_LENGTH, data.getSize());
 
-    // Update the checksum
-    checksum.process_block(compressed.begin() + COMPRESSION_HEADER_LENGTH, compressed.end());
+    auto headerLength = type == NONE ? CONTAINER_HEADER_LENGTH : COMPRESSED_HEADER_LENGTH;
+    out.resize(headerLength + length);
 
-    // If there are still bytes to be read
-    if (buf.getRemaining() >= 2)
+    if (revision)
     {
-        auto revision = buf.readShort();
-        assert(revision != INT16_MAX);
+        out.writeByte(static_cast<char>(*revision >> 8));
+        out.writeByte(static_cast<char>(*revision));
     }
+    return out;
+}
 
-    // Prepare to decompress the payload
-    filtering_streambuf<input> in;
-    std::stringstream out;
+/**
+ * Compresses many buffers in parallel.
+ * @param data      The data to compress.
+ * @param type      The type of compression.
+ * @param threads   The number of threads to compress with, or 0 to use the number of hardware threads.
+ * @param level     The compression level, from 1 to 9.
+ * @return          The containers, in the same order as the data, without revisions.
+ */
+std::vector<RSBuffer> Compression::compressAll(std::span<const RSBuffer> data, CompressionType type, size_t threads,
+                                               int level)
+{
+    std::vector<RSBuffer> containers(data.size(), RSBuffer(0));
+    parallelFor(
+        data.size(), [&](size_t i) { containers[i] = compress(data[i], type, std::nullopt, level); }, threads);
+    return containers;
+}
 
-    // Push the decompressor
-    if (type == BZIP2)
-        in.push(bzip2_decompressor());
-    else if (type == GZIP)
-    {
-        zlib_params params;  // Configure Zlib to disregard the GZIP header
-        params.window_bits = 16 + MAX_WBITS;
-        in.push(zlib_decompressor(params));
-    }
+/**
+ * Decompresses many containers in parallel.
+ * @param containers    The containers to decompress.
+ * @param threads       The number of threads to decompress with, or 0 to use the number of hardware threads.
+ * @return              The decompressed data, in the same order as the containers.
+ */
+std::vector<RSBuffer> Compression::decompressAll(std::span<const RSBuffer> containers, size_t threads)
+{
+    std::vector<RSBuffer> data(containers.size(), RSBuffer(0));
+    parallelFor(
+        containers.size(),
+        [&](size_t i) { data[i] = decompress(std::span(containers[i].begin(), containers[i].getSize())); },
+        threads);
+    return data;
+}
 
-    // Push the data to decompress, and copy it to the output buffer
-    in.push(compressed.readRange(compressedSize + COMPRESSION_HEADER_LENGTH));
-    copy(in, out);
+/**
+ * Reads the unencrypted header at the start of a container.
+ * @param data      The start of the container.
+ * @param length    The number of bytes available.
+ * @return          The header.
+ */
+ContainerHeader Compression::containerHeader(const char* data, size_t length)
+{
+    if (length < CONTAINER_HEADER_LENGTH)
+        throw std::runtime_error("Container is too short");
+    return { .type = static_cast<CompressionType>(data[0]), .compressedLength = decodeInt(data + 1) };
+}
 
-    // Copy the decompressed data to a buffer
-    auto decompressedData = out.str();
-    RSBuffer decompressed(decompressedData.data(), decompressedSize);
-    return decompressed;
-}
\ No newline at end of file
+/**
+ * Gets the name of a compression type.
+ * @param type  The compression type.
+ * @return      The name.
+ */
+const char* Compression::typeName(CompressionType type)
+{
+    return TYPE_NAMES.at(type);
+}
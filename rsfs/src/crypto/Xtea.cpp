@@ -0,0 +1,152 @@
+#include "util/BigEndian.hpp"
+
+#include <rsfs/compression/Compression.hpp>
+#include <rsfs/crypto/Xtea.hpp>
+
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * Deciphers a single block in place.
+     * @param block The block.
+     * @param key   The key.
+     */
+    void decipherBlock(char* block, const XteaKey& key)
+    {
+        auto v0  = decodeInt(block);
+        auto v1  = decodeInt(block + 4);
+        auto sum = XTEA_DELTA * XTEA_ROUNDS;
+        for (auto round = 0; round < XTEA_ROUNDS; round++)
+        {
+            v1 -= (((v0 << 4u) ^ (v0 >> 5u)) + v0) ^ (sum + key[(sum >> 11u) & 3u]);
+            sum -= XTEA_DELTA;
+            v0 -= (((v1 << 4u) ^ (v1 >> 5u)) + v1) ^ (sum + key[sum & 3u]);
+        }
+        encodeInt(block, v0);
+        encodeInt(block + 4, v1);
+    }
+
+#if defined(__SSE2__)
+    /**
+     * The number of blocks deciphered at once by the vector kernel.
+     */
+    constexpr const auto VECTOR_BLOCKS = 4;
+
+    /**
+     * Reverses the byte order of each word in a vector.
+     * @param value The vector.
+     * @return      The byte swapped vector.
+     */
+    __m128i byteSwap(__m128i value)
+    {
+        value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+        value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+    }
+
+    /**
+     * Deciphers four consecutive blocks in place. Every block uses the same key schedule, so each round is
+     * performed on all four blocks at once, with the first words of the blocks in one vector and the second
+     * words in another.
+     * @param blocks    The blocks.
+     * @param key       The key.
+     */
+    void decipherBlocks(char* blocks, const XteaKey& key)
+    {
+        // Load the blocks as [a0 a1 b0 b1] and [c0 c1 d0 d1], and rearrange them to [a0 b0 a1 b1] and [c0 d0 c1 d1]
+        auto low  = byteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks)));
+        auto high = byteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16)));
+        low       = _mm_shuffle_epi32(low, _MM_SHUFFLE(3, 1, 2, 0));
+        high      = _mm_shuffle_epi32(high, _MM_SHUFFLE(3, 1, 2, 0));
+
+        // Gather the first and second words of each block
+        auto v0 = _mm_unpacklo_epi64(low, high);
+        auto v1 = _mm_unpackhi_epi64(low, high);
+
+        auto sum = XTEA_DELTA * XTEA_ROUNDS;
+        for (auto round = 0; round < XTEA_ROUNDS; round++)
+        {
+            auto mix = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0);
+            v1       = _mm_sub_epi32(v1, _mm_xor_si128(mix, _mm_set1_epi32(sum + key[(sum >> 11u) & 3u])));
+            sum -= XTEA_DELTA;
+            mix = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1);
+            v0  = _mm_sub_epi32(v0, _mm_xor_si128(mix, _mm_set1_epi32(sum + key[sum & 3u])));
+        }
+
+        // Restore the original block layout
+        low  = _mm_shuffle_epi32(_mm_unpacklo_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+        high = _mm_shuffle_epi32(_mm_unpackhi_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks), byteSwap(low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks + 16), byteSwap(high));
+    }
+#endif
+}
+
+/**
+ * Deciphers a series of blocks in place.
+ * @param data      The data to decipher.
+ * @param length    The number of bytes to decipher.
+ * @param key       The key.
+ */
+void Xtea::decipher(char* data, size_t length, const XteaKey& key)
+{
+    auto blocks = length / XTEA_BLOCK_SIZE;
+    size_t block = 0;
+
+#if defined(__SSE2__)
+    for (; block + VECTOR_BLOCKS <= blocks; block += VECTOR_BLOCKS)
+        decipherBlocks(data + block * XTEA_BLOCK_SIZE, key);
+#endif
+
+    for (; block < blocks; block++)
+        decipherBlock(data + block * XTEA_BLOCK_SIZE, key);
+}
+
+/**
+ * Enciphers a series of blocks in place.
+ * @param data      The data to encipher.
+ * @param length    The number of bytes to encipher.
+ * @param key       The key.
+ */
+void Xtea::encipher(char* data, size_t length, const XteaKey& key)
+{
+    auto blocks = length / XTEA_BLOCK_SIZE;
+    for (size_t block = 0; block < blocks; block++)
+    {
+        auto* ptr    = data + block * XTEA_BLOCK_SIZE;
+        auto v0      = decodeInt(ptr);
+        auto v1      = decodeInt(ptr + 4);
+        uint32_t sum = 0;
+        for (auto round = 0; round < XTEA_ROUNDS; round++)
+        {
+            v0 += (((v1 << 4u) ^ (v1 >> 5u)) + v1) ^ (sum + key[sum & 3u]);
+            sum += XTEA_DELTA;
+            v1 += (((v0 << 4u) ^ (v0 >> 5u)) + v0) ^ (sum + key[(sum >> 11u) & 3u]);
+        }
+        encodeInt(ptr, v0);
+        encodeInt(ptr + 4, v1);
+    }
+}
+
+/**
+ * Deciphers the payload of an archive container in place.
+ * @param container The container.
+ * @param key       The key.
+ */
+void Xtea::decipherContainer(RSBuffer& container, const XteaKey& key)
+{
+    // Everything after the header is encrypted, up to the end of the compressed payload
+    auto length    = Compression::containerHeader(container.begin(), container.getSize()).encryptedLength();
+    auto available = container.getSize() - CONTAINER_HEADER_LENGTH;
+    if (length > available)
+        throw std::runtime_error("Container is shorter than its encrypted payload");
+
+    decipher(container.data() + CONTAINER_HEADER_LENGTH, length, key);
+}
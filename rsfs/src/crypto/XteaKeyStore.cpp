@@ -0,0 +1,187 @@
+#include <rsfs/crypto/XteaKeyStore.hpp>
+#include <rsfs/jag/Index.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+using namespace rsfs;
+
+/**
+ * The size of a binary key record, consisting of the region id and the four key words.
+ */
+constexpr const auto KEY_RECORD_SIZE = 20;
+
+/**
+ * The suffix of a JSON keys file.
+ */
+constexpr const auto JSON_SUFFIX = ".json";
+
+namespace
+{
+    /**
+     * Reads a key from a JSON array of four integers.
+     * @param array The array.
+     * @return      The key.
+     */
+    XteaKey readKey(const boost::property_tree::ptree& array)
+    {
+        if (array.size() != 4)
+            throw std::runtime_error("XTEA keys must have four words");
+
+        // Keys are usually written as signed integers
+        XteaKey key{};
+        auto word = 0;
+        for (auto&& [name, value]: array)
+            key[word++] = static_cast<uint32_t>(value.get_value<int64_t>());
+        return key;
+    }
+}
+
+/**
+ * Loads a key store from a file.
+ * @param path  The path to the keys file.
+ * @return      The key store.
+ */
+XteaKeyStore XteaKeyStore::load(const std::string& path)
+{
+    std::string_view suffix(JSON_SUFFIX);
+    if (path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0)
+        return loadJson(path);
+    return loadBinary(path);
+}
+
+/**
+ * Loads a key store from a JSON file.
+ * @param path  The path to the keys file.
+ * @return      The key store.
+ */
+XteaKeyStore XteaKeyStore::loadJson(const std::string& path)
+{
+    boost::property_tree::ptree root;
+    try
+    {
+        boost::property_tree::read_json(path, root);
+    }
+    catch (const boost::property_tree::json_parser_error& e)
+    {
+        throw std::runtime_error("Unable to read XTEA keys: " + e.message());
+    }
+
+    XteaKeyStore store;
+    for (auto&& [name, entry]: root)
+    {
+        auto keys = entry.get_child_optional("key");
+        if (!keys)
+            keys = entry.get_child_optional("keys");
+        if (!keys)
+            throw std::runtime_error("XTEA key entry is missing its key");
+        auto key = readKey(*keys);
+
+        // Keys for a specific archive take precedence over region keys
+        auto index   = entry.get_optional<size_t>("archive");
+        auto archive = entry.get_optional<size_t>("group");
+        if (index && archive)
+        {
+            store.put(*index, *archive, key);
+            continue;
+        }
+
+        auto region = entry.get_optional<uint32_t>("mapsquare");
+        if (!region)
+            region = entry.get_optional<uint32_t>("region");
+        if (!region)
+            throw std::runtime_error("XTEA key entry has no archive or region");
+        store.putRegion(*region, key);
+    }
+    return store;
+}
+
+/**
+ * Loads a key store from a binary file.
+ * @param path  The path to the keys file.
+ * @return      The key store.
+ */
+XteaKeyStore XteaKeyStore::loadBinary(const std::string& path)
+{
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream)
+        throw std::runtime_error("Unable to open XTEA keys file");
+
+    RSBuffer buf(stream);
+    if (buf.getSize() % KEY_RECORD_SIZE != 0)
+        throw std::runtime_error("XTEA keys file is truncated");
+
+    XteaKeyStore store;
+    while (buf.getRemaining() > 0)
+    {
+        auto region = buf.readInt();
+        XteaKey key{};
+        for (auto& word: key)
+            word = buf.readInt();
+        store.putRegion(region, key);
+    }
+    return store;
+}
+
+/**
+ * Stores the key for a specific archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param key       The key.
+ */
+void XteaKeyStore::put(size_t index, size_t archive, const XteaKey& key)
+{
+    archives_[{ index, archive }] = key;
+}
+
+/**
+ * Stores the key for a map region.
+ * @param region    The region id.
+ * @param key       The key.
+ */
+void XteaKeyStore::putRegion(uint32_t region, const XteaKey& key)
+{
+    landscapes_[landscapeNameHash(region)] = key;
+}
+
+/**
+ * Finds the key for an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param nameHash  The name hash of the archive.
+ * @return          The key, or null if the archive has no key.
+ */
+const XteaKey* XteaKeyStore::find(size_t index, size_t archive, int nameHash) const
+{
+    auto it = archives_.find({ index, archive });
+    if (it != archives_.end())
+        return &it->second;
+
+    if (index != MAPS)
+        return nullptr;
+
+    auto landscape = landscapes_.find(nameHash);
+    return landscape != landscapes_.end() ? &landscape->second : nullptr;
+}
+
+/**
+ * Calculates the name hash of a region's landscape archive, which is named "l<x>_<y>".
+ * @param region    The region id.
+ * @return          The name hash.
+ */
+int XteaKeyStore::landscapeNameHash(uint32_t region)
+{
+    std::stringstream name;
+    name << 'l' << ((region >> 8u) & 0xFFu) << '_' << (region & 0xFFu);
+
+    // Archive names are hashed in the same way as Java strings
+    uint32_t hash = 0;
+    for (auto c: name.str())
+        hash = hash * 31 + static_cast<uint8_t>(c);
+    return static_cast<int>(hash);
+}
@@ -5,6 +5,78 @@
 
 using namespace rsfs;
 
+/**
+ * The opcodes of an item definition.
+ */
+template<>
+struct rsfs::Opcodes<ItemDefinition>
+{
+    using Item = ItemDefinition;
+
+    /**
+     * Reads a list of modification pairs in the format of (old, new).
+     * @param buf           The buffer to read from.
+     * @param modifications The modifications to read into.
+     */
+    static void readModifications(RSBuffer& buf, std::vector<std::pair<size_t, size_t>>& modifications)
+    {
+        auto size = buf.readByte();
+        modifications.resize(size);
+
+        for (auto i = 0; i < size; i++)
+        {
+            auto from           = buf.readShort();
+            auto to             = buf.readShort();
+            modifications.at(i) = std::pair(from, to);
+        }
+    }
+
+    static constexpr std::array table = {
+        Opcode<Item>{ 1, [](Item& def, RSBuffer& buf, uint8_t) { def.model_ = buf.readShort(); } },
+        Opcode<Item>{ 2, [](Item& def, RSBuffer& buf, uint8_t) { def.name_ = buf.readString(); } },
+        Opcode<Item>{ 4, [](Item& def, RSBuffer& buf, uint8_t) { def.spriteScale_ = buf.readShort(); } },
+        Opcode<Item>{ 5, [](Item& def, RSBuffer& buf, uint8_t) { def.spritePitch_ = buf.readShort(); } },
+        Opcode<Item>{ 6, [](Item& def, RSBuffer& buf, uint8_t) { def.spriteCameraRoll_ = buf.readShort(); } },
+        Opcode<Item>{ 7, [](Item& def, RSBuffer& buf, uint8_t) { def.spriteTranslateX_ = buf.readShort(); } },
+        Opcode<Item>{ 8, [](Item& def, RSBuffer& buf, uint8_t) { def.spriteTranslateY_ = buf.readShort(); } },
+        Opcode<Item>{ 11, [](Item& def, RSBuffer&, uint8_t) { def.stackable_ = true; } },
+        Opcode<Item>{ 12, [](Item& def, RSBuffer& buf, uint8_t) { def.value_ = buf.readInt(); } },
+        Opcode<Item>{ 16, [](Item& def, RSBuffer&, uint8_t) { def.members_ = true; } },
+        Opcode<Item>{ 18, [](Item& def, RSBuffer& buf, uint8_t) { def.stackSize_ = buf.readShort(); } },
+        Opcode<Item>{ 23, [](Item& def, RSBuffer& buf, uint8_t) { def.primaryMaleModel_ = buf.readShort(); } },
+        Opcode<Item>{ 24, [](Item& def, RSBuffer& buf, uint8_t) { def.secondaryMaleModel_ = buf.readShort(); } },
+        Opcode<Item>{ 25, [](Item& def, RSBuffer& buf, uint8_t) { def.primaryFemaleModel_ = buf.readShort(); } },
+        Opcode<Item>{ 26, [](Item& def, RSBuffer& buf, uint8_t) { def.secondaryFemaleModel_ = buf.readShort(); } },
+        Opcode<Item>{ 30, 34,
+                      [](Item& def, RSBuffer& buf, uint8_t opcode) { def.groundOptions_[opcode - 30] = buf.readString(); } },
+        Opcode<Item>{ 35, 39,
+                      [](Item& def, RSBuffer& buf, uint8_t opcode) { def.options_[opcode - 35] = buf.readString(); } },
+        Opcode<Item>{ 40, [](Item& def, RSBuffer& buf, uint8_t) { readModifications(buf, def.colourModifications_); } },
+        Opcode<Item>{ 41, [](Item& def, RSBuffer& buf, uint8_t) { readModifications(buf, def.textureModifications_); } },
+
+        // Opcodes that are decoded to keep the stream in sync, but whose values aren't exposed yet
+        Opcode<Item>{ 13, 14, skip<Item, 1> },     // Wear positions
+        Opcode<Item>{ 27, skip<Item, 1> },         // Wear position
+        Opcode<Item>{ 42, skipList<Item, 1> },     // Recolour palette
+        Opcode<Item>{ 65, skip<Item, 0> },         // Tradeable
+        Opcode<Item>{ 78, 79, skip<Item, 2> },     // Tertiary male and female models
+        Opcode<Item>{ 90, 93, skip<Item, 2> },     // Head models
+        Opcode<Item>{ 95, skip<Item, 2> },         // Sprite yaw
+        Opcode<Item>{ 96, skip<Item, 1> },         // Dummy item
+        Opcode<Item>{ 97, 98, skip<Item, 2> },     // Noted id and template
+        Opcode<Item>{ 100, 109, skip<Item, 4> },   // Stack variants
+        Opcode<Item>{ 110, 112, skip<Item, 2> },   // Model scale
+        Opcode<Item>{ 113, 115, skip<Item, 1> },   // Ambient, contrast and team
+        Opcode<Item>{ 121, 122, skip<Item, 2> },   // Lent id and template
+        Opcode<Item>{ 125, 126, skip<Item, 3> },   // Male and female wield offsets
+        Opcode<Item>{ 127, 130, skip<Item, 3> },   // Cursor options
+        Opcode<Item>{ 132, skipList<Item, 2> },    // Campaigns
+        Opcode<Item>{ 134, skip<Item, 1> },        // Pick size shift
+        Opcode<Item>{ 139, 140, skip<Item, 2> },   // Bound id and template
+        Opcode<Item>{ 249, skipParams<Item> },     // Parameters
+    };
+};
+
 /**
  * The buffer to read from.
  * @param fs    The filesystem to read from.
@@ -25,66 +97,5 @@ ItemDefinition ItemDefinition::forId(RSFileSystem& fs, size_t id)
  */
 ItemDefinition ItemDefinition::decode(RSBuffer& buf)
 {
-    ItemDefinition def;
-    uint8_t opcode;
-    while ((opcode = buf.readByte()) != 0)
-    {
-        if (opcode == 1)
-            def.model_ = buf.readShort();
-        if (opcode == 2)
-            def.name_ = buf.readString();
-        if (opcode == 4)
-            def.spriteScale_ = buf.readShort();
-        if (opcode == 5)
-            def.spritePitch_ = buf.readShort();
-        if (opcode == 6)
-            def.spriteCameraRoll_ = buf.readShort();
-        if (opcode == 7)
-            def.spriteTranslateX_ = buf.readShort();
-        if (opcode == 8)
-            def.spriteTranslateY_ = buf.readShort();
-        if (opcode == 11)
-            def.stackable_ = true;
-        if (opcode == 12)
-            def.value_ = buf.readInt();
-        if (opcode == 16)
-            def.members_ = true;
-        if (opcode == 18)
-            def.stackSize_ = buf.readShort();
-        if (opcode == 23)
-            def.primaryMaleModel_ = buf.readShort();
-        if (opcode == 24)
-            def.secondaryMaleModel_ = buf.readShort();
-        if (opcode == 25)
-            def.primaryFemaleModel_ = buf.readShort();
-        if (opcode == 26)
-            def.secondaryFemaleModel_ = buf.readShort();
-        if (opcode >= 30 && opcode < 35)
-            def.groundOptions_[opcode - 30] = buf.readString();
-        if (opcode >= 35 && opcode < 40)
-            def.options_[opcode - 35] = buf.readString();
-        if (opcode == 40)
-        {
-            auto size     = buf.readByte();
-            auto& colours = def.colourModifications_;
-            colours.resize(size);
-
-            for (auto i = 0; i < size; i++)
-            {
-                colours.at(i) = std::pair(buf.readShort(), buf.readShort());
-            }
-        }
-        if (opcode == 41)
-        {
-            auto size      = buf.readByte();
-            auto& textures = def.textureModifications_;
-            textures.resize(size);
-
-            for (auto i = 0; i < size; i++)
-            {
-                textures.at(i) = std::pair(buf.readShort(), buf.readShort());
-            }
-        }
-    }
-    return def;
-}
\ No newline at end of file
+    return DefinitionDecoder<ItemDefinition>::decode(buf);
+}
@@ -0,0 +1,357 @@
+#include "util/Advise.hpp"
+
+#include <rsfs/defs/ItemSnapshot.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace rsfs;
+
+/**
+ * The magic value at the start of an item snapshot.
+ */
+constexpr const std::array<char, 8> SNAPSHOT_MAGIC = { 'R', 'S', 'F', 'S', 'I', 'T', 'E', 'M' };
+
+/**
+ * The version of the snapshot format. This must be incremented whenever the layout changes.
+ */
+constexpr const uint32_t SNAPSHOT_VERSION = 1;
+
+/**
+ * A value written in native byte order, used to reject snapshots written on a host with a different byte order.
+ */
+constexpr const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/**
+ * The alignment of each section in the snapshot.
+ */
+constexpr const auto SECTION_ALIGNMENT = 8;
+
+namespace
+{
+    /**
+     * The sections of a snapshot, in the order they are written.
+     */
+    enum Section : uint32_t
+    {
+        ARCHIVES,
+        FLAGS,
+        MODEL,
+        NAME,
+        OPTIONS,
+        GROUND_OPTIONS,
+        VALUE,
+        STACK_SIZE,
+        WORN_MODELS,
+        SPRITE,
+        COLOURS,
+        TEXTURES,
+        MODIFICATIONS,
+        OPTION_SETS,
+        STRING_OFFSETS,
+        STRING_DATA,
+        SECTION_COUNT,
+    };
+
+    /**
+     * The location of a section in the snapshot.
+     */
+    struct SectionEntry
+    {
+        /**
+         * The offset of the section from the start of the file.
+         */
+        uint64_t offset;
+
+        /**
+         * The number of elements in the section.
+         */
+        uint64_t count;
+    };
+
+    /**
+     * The header at the start of a snapshot.
+     */
+    struct SnapshotHeader
+    {
+        /**
+         * The magic value.
+         */
+        std::array<char, 8> magic;
+
+        /**
+         * The version of the snapshot format.
+         */
+        uint32_t version;
+
+        /**
+         * The byte order mark.
+         */
+        uint32_t byteOrder;
+
+        /**
+         * The location of each section.
+         */
+        std::array<SectionEntry, SECTION_COUNT> sections;
+    };
+
+    /**
+     * Writes the sections of a snapshot to a stream.
+     */
+    class SectionWriter
+    {
+    public:
+        /**
+         * Creates a writer, reserving space for the header.
+         * @param stream    The stream to write to.
+         */
+        explicit SectionWriter(std::ofstream& stream): stream_(stream)
+        {
+            header_.magic     = SNAPSHOT_MAGIC;
+            header_.version   = SNAPSHOT_VERSION;
+            header_.byteOrder = BYTE_ORDER_MARK;
+            stream_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+            position_ = sizeof(header_);
+        }
+
+        /**
+         * Writes a section.
+         * @param section   The section.
+         * @param data      The elements of the section.
+         * @param count     The number of elements.
+         */
+        template<typename T>
+        void write(Section section, const T* data, size_t count)
+        {
+            static_assert(std::is_standard_layout_v<T>);
+
+            // Align the section
+            static constexpr std::array<char, SECTION_ALIGNMENT> padding{};
+            auto misalignment = position_ % SECTION_ALIGNMENT;
+            if (misalignment != 0)
+            {
+                stream_.write(padding.data(), SECTION_ALIGNMENT - misalignment);
+                position_ += SECTION_ALIGNMENT - misalignment;
+            }
+
+            header_.sections[section] = { position_, count };
+            stream_.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+            position_ += count * sizeof(T);
+        }
+
+        /**
+         * Writes a section from a vector.
+         * @param section   The section.
+         * @param values    The elements of the section.
+         */
+        template<typename T>
+        void write(Section section, const std::vector<T>& values)
+        {
+            write(section, values.data(), values.size());
+        }
+
+        /**
+         * Rewrites the header, now that the location of every section is known.
+         */
+        void finish()
+        {
+            stream_.seekp(0);
+            stream_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        }
+
+    private:
+        /**
+         * The stream to write to.
+         */
+        std::ofstream& stream_;
+
+        /**
+         * The header of the snapshot.
+         */
+        SnapshotHeader header_{};
+
+        /**
+         * The current position in the stream.
+         */
+        uint64_t position_{ 0 };
+    };
+}
+
+/**
+ * Writes an item table to a snapshot file.
+ * @param table The item table.
+ * @param items The item index that the table was loaded from.
+ * @param path  The path to write the snapshot to.
+ */
+void ItemSnapshot::write(const ItemTable& table, const IndexFile& items, const std::string& path)
+{
+    // The versions of the archives that the table was built from
+    std::vector<ArchiveVersion> archives;
+    for (auto archiveId: items.archiveIds())
+    {
+        auto& data = items.archiveData(archiveId);
+        archives.push_back({ static_cast<uint32_t>(archiveId), data.crc, static_cast<uint32_t>(data.revision), 0 });
+    }
+
+    // Flatten the interned strings into a single block
+    std::vector<uint32_t> stringOffsets;
+    std::vector<char> stringData;
+    for (auto&& string: table.strings_)
+    {
+        stringOffsets.push_back(stringData.size());
+        stringData.insert(stringData.end(), string.begin(), string.end());
+    }
+    stringOffsets.push_back(stringData.size());
+
+    // Write to a temporary file first, as truncating the snapshot would break the processes that have it mapped
+    auto temporary = path + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!stream)
+            throw std::runtime_error("Unable to open snapshot for writing");
+
+        SectionWriter writer(stream);
+        writer.write(ARCHIVES, archives);
+        writer.write(FLAGS, table.flags_);
+        writer.write(MODEL, table.model_);
+        writer.write(NAME, table.name_);
+        writer.write(OPTIONS, table.options_);
+        writer.write(GROUND_OPTIONS, table.groundOptions_);
+        writer.write(VALUE, table.value_);
+        writer.write(STACK_SIZE, table.stackSize_);
+        writer.write(WORN_MODELS, table.wornModels_);
+        writer.write(SPRITE, table.sprite_);
+        writer.write(COLOURS, table.colours_);
+        writer.write(TEXTURES, table.textures_);
+        writer.write(MODIFICATIONS, table.modifications_);
+        writer.write(OPTION_SETS, table.optionSets_);
+        writer.write(STRING_OFFSETS, stringOffsets);
+        writer.write(STRING_DATA, stringData);
+        writer.finish();
+
+        if (!stream)
+            throw std::runtime_error("Unable to write snapshot");
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Unable to replace snapshot");
+}
+
+/**
+ * Maps a snapshot file.
+ * @param path  The path to the snapshot.
+ */
+ItemSnapshot::ItemSnapshot(const std::string& path): file_(path)
+{
+    if (file_.size() < sizeof(SnapshotHeader))
+        throw std::runtime_error("Snapshot is truncated");
+
+    // Every section is validated straight away, and items are then looked up by id in no particular order
+    adviseMapping(file_.data(), file_.size(), RANDOM);
+
+    // Validate the header
+    SnapshotHeader header{};
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC)
+        throw std::runtime_error("Not an item snapshot");
+    if (header.version != SNAPSHOT_VERSION || header.byteOrder != BYTE_ORDER_MARK)
+        throw std::runtime_error("Incompatible item snapshot");
+
+    // Map each section
+    auto& s        = header.sections;
+    archives_      = section<ArchiveVersion>(s[ARCHIVES].offset, s[ARCHIVES].count);
+    flags_         = section<uint8_t>(s[FLAGS].offset, s[FLAGS].count);
+    model_         = section<uint16_t>(s[MODEL].offset, s[MODEL].count);
+    name_          = section<uint32_t>(s[NAME].offset, s[NAME].count);
+    options_       = section<uint32_t>(s[OPTIONS].offset, s[OPTIONS].count);
+    groundOptions_ = section<uint32_t>(s[GROUND_OPTIONS].offset, s[GROUND_OPTIONS].count);
+    value_         = section<int32_t>(s[VALUE].offset, s[VALUE].count);
+    stackSize_     = section<uint16_t>(s[STACK_SIZE].offset, s[STACK_SIZE].count);
+    wornModels_    = section<std::array<uint16_t, 4>>(s[WORN_MODELS].offset, s[WORN_MODELS].count);
+    sprite_        = section<std::array<uint16_t, 5>>(s[SPRITE].offset, s[SPRITE].count);
+    colours_       = section<ItemTable::Range>(s[COLOURS].offset, s[COLOURS].count);
+    textures_      = section<ItemTable::Range>(s[TEXTURES].offset, s[TEXTURES].count);
+    modifications_ = section<std::pair<uint16_t, uint16_t>>(s[MODIFICATIONS].offset, s[MODIFICATIONS].count);
+    optionSets_    = section<std::array<uint32_t, NUM_OPTIONS>>(s[OPTION_SETS].offset, s[OPTION_SETS].count);
+    stringOffsets_ = section<uint32_t>(s[STRING_OFFSETS].offset, s[STRING_OFFSETS].count);
+    stringData_    = section<char>(s[STRING_DATA].offset, s[STRING_DATA].count);
+
+    // Every item column must cover the same ids
+    auto size = flags_.size();
+    if (model_.size() != size || name_.size() != size || options_.size() != size || groundOptions_.size() != size ||
+        value_.size() != size || stackSize_.size() != size || wornModels_.size() != size || sprite_.size() != size ||
+        colours_.size() != size || textures_.size() != size || stringOffsets_.empty())
+    {
+        throw std::runtime_error("Item snapshot is corrupt");
+    }
+
+    // The accessors index the sections with ids and ranges read from the file, so check them all once here
+    auto stringCount = stringOffsets_.size() - 1;
+    for (size_t i = 0; i < stringCount; i++)
+    {
+        if (stringOffsets_[i] > stringOffsets_[i + 1])
+            throw std::runtime_error("Item snapshot is corrupt");
+    }
+    if (stringOffsets_.back() > stringData_.size())
+        throw std::runtime_error("Item snapshot is corrupt");
+
+    for (auto&& set: optionSets_)
+    {
+        if (std::any_of(set.begin(), set.end(), [&](auto id) { return id >= stringCount; }))
+            throw std::runtime_error("Item snapshot is corrupt");
+    }
+
+    auto inModifications = [&](const ItemTable::Range& range) {
+        return range.offset <= modifications_.size() && range.length <= modifications_.size() - range.offset;
+    };
+    for (size_t id = 0; id < size; id++)
+    {
+        if (name_[id] >= stringCount || options_[id] >= optionSets_.size() ||
+            groundOptions_[id] >= optionSets_.size() || !inModifications(colours_[id]) ||
+            !inModifications(textures_[id]))
+        {
+            throw std::runtime_error("Item snapshot is corrupt");
+        }
+    }
+}
+
+/**
+ * Checks if this snapshot was built from the current revision of every item archive.
+ * @param items The item index.
+ * @return      If the snapshot is up to date.
+ */
+bool ItemSnapshot::matches(const IndexFile& items) const
+{
+    auto archiveIds = items.archiveIds();
+    if (archiveIds.size() != archives_.size())
+        return false;
+
+    for (auto&& archive: archives_)
+    {
+        if (!std::binary_search(archiveIds.begin(), archiveIds.end(), archive.id))
+            return false;
+
+        auto& data = items.archiveData(archive.id);
+        if (data.crc != archive.crc || data.revision != archive.revision)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Gets a section of the mapped file.
+ * @param offset    The offset of the section.
+ * @param count     The number of elements in the section.
+ * @return          The section.
+ */
+template<typename T>
+std::span<const T> ItemSnapshot::section(uint64_t offset, uint64_t count) const
+{
+    if (offset % alignof(T) != 0 || offset > file_.size() || count > (file_.size() - offset) / sizeof(T))
+        throw std::runtime_error("Item snapshot is corrupt");
+    return { reinterpret_cast<const T*>(file_.data() + offset), count };
+}
@@ -0,0 +1,175 @@
+#include "util/Parallel.hpp"
+
+#include <rsfs/defs/ItemTable.hpp>
+#include <rsfs/jag/Index.hpp>
+
+using namespace rsfs;
+
+/**
+ * Decodes every item definition in the filesystem, decoding one archive per task on a thread pool.
+ * @param fs        The filesystem to read from.
+ * @param threads   The number of worker threads, or 0 to use the number of hardware threads.
+ * @return          The item table.
+ */
+ItemTable ItemTable::load(RSFileSystem& fs, size_t threads)
+{
+    auto& items     = fs.getIndex(Index::CONFIG_OBJ);
+    auto archiveIds = items.archiveIds();
+
+    // Decode each archive on the thread pool
+    std::vector<std::vector<std::pair<size_t, ItemDefinition>>> decoded(archiveIds.size());
+    parallelFor(
+        archiveIds.size(),
+        [&](size_t i) {
+            auto archiveId = archiveIds.at(i);
+            auto& archive  = items.getArchive(archiveId);
+            auto& defs     = decoded.at(i);
+
+            for (auto&& file: archive.getFiles())
+            {
+                auto id = (archiveId << 8u) | file.id;
+                RSBuffer contents(file.contents.data(), file.contents.size());
+                defs.emplace_back(id, ItemDefinition::decode(contents));
+            }
+        },
+        threads);
+
+    // Pack the definitions into the table, in id order so that interned ids are deterministic
+    ItemTable table;
+    if (!archiveIds.empty())
+        table.reserve(((archiveIds.back() + 1) << 8u) - 1);
+
+    for (auto&& defs: decoded)
+    {
+        for (auto&& [id, def]: defs)
+            table.add(id, def);
+    }
+    return table;
+}
+
+/**
+ * Adds an item definition to this table.
+ * @param id    The item id.
+ * @param def   The item definition.
+ */
+void ItemTable::add(size_t id, const ItemDefinition& def)
+{
+    reserve(id);
+
+    uint8_t flags = FLAG_PRESENT;
+    if (def.members())
+        flags |= FLAG_MEMBERS;
+    if (def.stackable())
+        flags |= FLAG_STACKABLE;
+
+    flags_[id]         = flags;
+    model_[id]         = def.model();
+    name_[id]          = intern(std::string(def.name()));
+    options_[id]       = intern(def.options());
+    groundOptions_[id] = intern(def.groundOptions());
+    value_[id]         = static_cast<int32_t>(def.value());
+    stackSize_[id]     = def.stackSize();
+    colours_[id]       = append(def.colourModifications());
+    textures_[id]      = append(def.textureModifications());
+
+    // Worn models, in the order primary male, secondary male, primary female and secondary female
+    auto& worn = wornModels_[id];
+    worn[0]    = def.primaryMaleModel();
+    worn[1]    = def.secondaryMaleModel();
+    worn[2]    = def.primaryFemaleModel();
+    worn[3]    = def.secondaryFemaleModel();
+
+    // Inventory sprite, in the order scale, pitch, camera roll, x translation and y translation
+    auto& sprite = sprite_[id];
+    sprite[0]    = def.spriteScale();
+    sprite[1]    = def.spritePitch();
+    sprite[2]    = def.spriteCameraRoll();
+    sprite[3]    = def.spriteTranslateX();
+    sprite[4]    = def.spriteTranslateY();
+}
+
+/**
+ * Gets the approximate number of bytes used by this table.
+ * @return  The memory usage, in bytes.
+ */
+size_t ItemTable::memoryUsage() const
+{
+    auto usage = flags_.capacity() * sizeof(uint8_t);
+    usage += (model_.capacity() + stackSize_.capacity()) * sizeof(uint16_t);
+    usage += (name_.capacity() + options_.capacity() + groundOptions_.capacity()) * sizeof(uint32_t);
+    usage += value_.capacity() * sizeof(int32_t);
+    usage += wornModels_.capacity() * sizeof(std::array<uint16_t, 4>);
+    usage += sprite_.capacity() * sizeof(std::array<uint16_t, 5>);
+    usage += (colours_.capacity() + textures_.capacity()) * sizeof(Range);
+    usage += modifications_.capacity() * sizeof(std::pair<uint16_t, uint16_t>);
+    usage += optionSets_.capacity() * sizeof(std::array<uint32_t, NUM_OPTIONS>);
+    for (auto&& string: strings_)
+        usage += sizeof(std::string) + (string.capacity() > 15 ? string.capacity() : 0);
+    return usage;
+}
+
+/**
+ * Ensures that the columns can hold a specified item id.
+ * @param id    The item id.
+ */
+void ItemTable::reserve(size_t id)
+{
+    if (id < flags_.size())
+        return;
+
+    auto size = id + 1;
+    flags_.resize(size);
+    model_.resize(size);
+    name_.resize(size);
+    options_.resize(size);
+    groundOptions_.resize(size);
+    value_.resize(size);
+    stackSize_.resize(size);
+    wornModels_.resize(size);
+    sprite_.resize(size);
+    colours_.resize(size);
+    textures_.resize(size);
+}
+
+/**
+ * Interns a string.
+ * @param value The string.
+ * @return      The id of the interned string.
+ */
+uint32_t ItemTable::intern(const std::string& value)
+{
+    auto [it, inserted] = stringIds_.try_emplace(value, strings_.size());
+    if (inserted)
+        strings_.push_back(value);
+    return it->second;
+}
+
+/**
+ * Interns a set of options.
+ * @param options   The options.
+ * @return          The id of the interned option set.
+ */
+uint32_t ItemTable::intern(const std::array<std::string, NUM_OPTIONS>& options)
+{
+    std::array<uint32_t, NUM_OPTIONS> set{};
+    for (auto i = 0; i < NUM_OPTIONS; i++)
+        set[i] = intern(options[i]);
+
+    auto [it, inserted] = optionSetIds_.try_emplace(set, optionSets_.size());
+    if (inserted)
+        optionSets_.push_back(set);
+    return it->second;
+}
+
+/**
+ * Appends a list of modifications to the shared modification array.
+ * @param modifications The modifications.
+ * @return              The range of the appended modifications.
+ */
+ItemTable::Range ItemTable::append(const std::vector<std::pair<size_t, size_t>>& modifications)
+{
+    Range range{ static_cast<uint32_t>(modifications_.size()), static_cast<uint32_t>(modifications.size()) };
+    for (auto&& [from, to]: modifications)
+        modifications_.emplace_back(from, to);
+    return range;
+}
@@ -0,0 +1,207 @@
+#include "util/Parallel.hpp"
+
+#include <rsfs/diff/CacheDiff.hpp>
+
+#include <algorithm>
+#include <set>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * An archive present in both caches whose contents need to be compared.
+     */
+    struct PendingArchive
+    {
+        /**
+         * The id of the index.
+         */
+        size_t index;
+
+        /**
+         * The change the contents are compared for.
+         */
+        ArchiveChange* change;
+    };
+
+    /**
+     * Checks if an archive's metadata is identical in both caches.
+     * @param from  The metadata in the old cache.
+     * @param to    The metadata in the new cache.
+     * @return      If the metadata is identical.
+     */
+    bool sameMetadata(const ArchiveData& from, const ArchiveData& to)
+    {
+        if (from.crc != to.crc || from.revision != to.revision || from.nameHash != to.nameHash ||
+            from.files.size() != to.files.size())
+            return false;
+
+        // A renamed file keeps its id and contents, so only its name hash shows the change
+        return std::equal(from.files.begin(), from.files.end(), to.files.begin(),
+                          [](const FileData& first, const FileData& second)
+                          { return first.id == second.id && first.nameHash == second.nameHash; });
+    }
+
+    /**
+     * Compares the files of an archive in both caches.
+     * @param from      The archive in the old cache.
+     * @param to        The archive in the new cache.
+     * @param change    The change to record the differing files in.
+     */
+    void compareFiles(const Archive& from, const Archive& to, ArchiveChange& change)
+    {
+        auto oldFiles = from.getFiles();
+        auto newFiles = to.getFiles();
+
+        // Both lists are sorted by id, so they can be merged
+        auto oldFile = oldFiles.begin();
+        auto newFile = newFiles.begin();
+        while (oldFile != oldFiles.end() || newFile != newFiles.end())
+        {
+            if (newFile == newFiles.end() || (oldFile != oldFiles.end() && oldFile->id < newFile->id))
+            {
+                change.files.push_back({ oldFile->id, REMOVED });
+                ++oldFile;
+            }
+            else if (oldFile == oldFiles.end() || newFile->id < oldFile->id)
+            {
+                change.files.push_back({ newFile->id, ADDED });
+                ++newFile;
+            }
+            else
+            {
+                if (oldFile->nameHash != newFile->nameHash || !std::ranges::equal(oldFile->contents, newFile->contents))
+                    change.files.push_back({ newFile->id, CHANGED });
+                ++oldFile;
+                ++newFile;
+            }
+        }
+    }
+}
+
+/**
+ * Compares two caches.
+ * @param from      The old cache.
+ * @param to        The new cache.
+ * @param options   The options to compare the caches with.
+ * @return          The differences.
+ */
+CacheDiff CacheDiff::compare(RSFileSystem& from, RSFileSystem& to, DiffOptions options)
+{
+    CacheDiff diff;
+    auto indexCount = std::max(from.indexCount(), to.indexCount());
+    diff.indices_.reserve(indexCount);
+
+    // Compare the reference tables, which are already in memory
+    for (size_t id = 0; id < indexCount; id++)
+    {
+        if (id >= from.indexCount() || id >= to.indexCount())
+        {
+            auto added  = id >= from.indexCount();
+            auto& index = added ? to.getIndex(id) : from.getIndex(id);
+            diff.indices_.push_back({ .id          = id,
+                                      .type        = added ? ADDED : REMOVED,
+                                      .oldRevision = added ? 0 : index.revision(),
+                                      .newRevision = added ? index.revision() : 0 });
+            continue;
+        }
+
+        auto& oldIndex = from.getIndex(id);
+        auto& newIndex = to.getIndex(id);
+        IndexChange change{ .id = id, .oldRevision = oldIndex.revision(), .newRevision = newIndex.revision() };
+
+        auto oldIds = oldIndex.archiveIds();
+        auto newIds = newIndex.archiveIds();
+        std::set<size_t> archiveIds(oldIds.begin(), oldIds.end());
+        archiveIds.insert(newIds.begin(), newIds.end());
+
+        for (auto archiveId: archiveIds)
+        {
+            auto inOld = std::binary_search(oldIds.begin(), oldIds.end(), archiveId);
+            auto inNew = std::binary_search(newIds.begin(), newIds.end(), archiveId);
+            if (!inOld)
+            {
+                change.archives.push_back(
+                    { .id = archiveId, .type = ADDED, .newRevision = newIndex.archiveData(archiveId).revision });
+                continue;
+            }
+            if (!inNew)
+            {
+                change.archives.push_back(
+                    { .id = archiveId, .type = REMOVED, .oldRevision = oldIndex.archiveData(archiveId).revision });
+                continue;
+            }
+
+            auto& oldData = oldIndex.archiveData(archiveId);
+            auto& newData = newIndex.archiveData(archiveId);
+            if (!sameMetadata(oldData, newData))
+            {
+                change.archives.push_back({ .id          = archiveId,
+                                            .type        = CHANGED,
+                                            .oldRevision = oldData.revision,
+                                            .newRevision = newData.revision,
+                                            .renamed     = oldData.nameHash != newData.nameHash });
+            }
+        }
+
+        if (!change.archives.empty() || change.oldRevision != change.newRevision)
+            diff.indices_.push_back(std::move(change));
+    }
+
+    if (!options.compareContents)
+        return diff;
+
+    // Read and compare the archives whose metadata differs on the thread pool
+    std::vector<PendingArchive> pending;
+    for (auto&& index: diff.indices_)
+    {
+        if (index.type != CHANGED)
+            continue;
+        for (auto&& archive: index.archives)
+        {
+            if (archive.type == CHANGED)
+                pending.push_back({ index.id, &archive });
+        }
+    }
+
+    parallelFor(
+        pending.size(),
+        [&](size_t i) {
+            auto& [index, change] = pending.at(i);
+            auto& oldIndex        = from.getIndex(index);
+            auto& newIndex        = to.getIndex(index);
+
+            std::unique_ptr<Archive> oldArchive;
+            std::unique_ptr<Archive> newArchive;
+            try
+            {
+                oldArchive = oldIndex.loadUncached(change->id);
+                newArchive = newIndex.loadUncached(change->id);
+            }
+            catch (const std::exception&)
+            {
+                // Archives that can't be decompressed, such as encrypted ones without keys, are compared as they
+                // are stored
+                auto oldContainer      = oldIndex.readArchive(change->id);
+                auto newContainer      = newIndex.readArchive(change->id);
+                change->compressedOnly = !std::equal(oldContainer.begin(), oldContainer.end(),
+                                                     newContainer.begin(), newContainer.end());
+                return;
+            }
+            compareFiles(*oldArchive, *newArchive, *change);
+        },
+        options.threads);
+
+    // Drop the archives whose contents turned out to be identical, and then the indices left without changes
+    for (auto&& index: diff.indices_)
+    {
+        std::erase_if(index.archives, [](const ArchiveChange& archive) {
+            return archive.type == CHANGED && archive.files.empty() && !archive.compressedOnly && !archive.renamed;
+        });
+    }
+    std::erase_if(diff.indices_, [](const IndexChange& index) {
+        return index.type == CHANGED && index.archives.empty() && index.oldRevision == index.newRevision;
+    });
+    return diff;
+}
@@ -0,0 +1,210 @@
+#include "util/Parallel.hpp"
+
+#include <rsfs/export/CacheExporter.hpp>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+using namespace rsfs;
+
+/**
+ * The magic value at the start of a packed export.
+ */
+constexpr const std::array<char, 8> PACK_MAGIC = { 'R', 'S', 'F', 'S', 'P', 'A', 'C', 'K' };
+
+/**
+ * The version of the packed export format. This must be incremented whenever the layout changes.
+ */
+constexpr const uint32_t PACK_VERSION = 1;
+
+/**
+ * A value written in native byte order, so that readers can detect a packed export written on a host with a
+ * different byte order.
+ */
+constexpr const uint32_t PACK_BYTE_ORDER_MARK = 0x01020304;
+
+namespace
+{
+    /**
+     * An archive to export.
+     */
+    struct ExportTask
+    {
+        /**
+         * The index the archive is in.
+         */
+        IndexFile* index;
+
+        /**
+         * The id of the archive.
+         */
+        size_t archive;
+    };
+
+    /**
+     * Collects the archives to export, and writes the manifest of each index when exporting to a directory.
+     * @param fs        The filesystem.
+     * @param path      The directory to write the manifests to.
+     * @param options   The export options.
+     * @return          The archives to export.
+     */
+    std::vector<ExportTask> collect(RSFileSystem& fs, const std::filesystem::path& path, const ExportOptions& options)
+    {
+        auto indices = options.indices;
+        if (indices.empty())
+        {
+            for (size_t id = 0; id < fs.indexCount(); id++)
+                indices.push_back(id);
+        }
+
+        std::vector<ExportTask> tasks;
+        for (auto id: indices)
+        {
+            auto& index = fs.getIndex(id);
+            auto ids    = index.archiveIds();
+            if (options.format == DIRECTORY)
+            {
+                std::filesystem::create_directories(path / std::to_string(id));
+                std::ofstream manifest(path / std::to_string(id) / "manifest.tsv", std::ios::out | std::ios::trunc);
+                manifest << "archive\tarchive_name_hash\tfile\tfile_name_hash\n";
+                for (auto archiveId: ids)
+                {
+                    auto& data = index.archiveData(archiveId);
+                    for (auto&& file: data.files)
+                    {
+                        manifest << archiveId << '\t' << data.nameHash << '\t' << file.id << '\t'
+                                 << static_cast<int32_t>(file.nameHash) << '\n';
+                    }
+                }
+                if (!manifest)
+                    throw std::runtime_error("Unable to write export manifest");
+            }
+
+            for (auto archiveId: ids)
+                tasks.push_back({ &index, archiveId });
+        }
+        return tasks;
+    }
+}
+
+/**
+ * Exports a cache.
+ * @param fs        The filesystem to export.
+ * @param path      The directory or packed file to write to.
+ * @param options   The options to export the cache with.
+ * @return          The totals of the export.
+ */
+ExportStats CacheExporter::write(RSFileSystem& fs, const std::string& path, ExportOptions options)
+{
+    auto tasks = collect(fs, path, options);
+
+    // A packed export is written to a temporary file first, so that a partial export is never mistaken for a whole one
+    auto temporary = path + ".tmp";
+    std::ofstream pack;
+    if (options.format == PACKED)
+    {
+        pack.open(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        PackHeader header{};
+        pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!pack)
+            throw std::runtime_error("Unable to create packed export");
+    }
+
+    std::mutex packMutex;
+    uint64_t packOffset = sizeof(PackHeader);
+    std::vector<PackRecord> records;
+
+    std::atomic<size_t> archives{ 0 }, files{ 0 }, bytes{ 0 }, failures{ 0 };
+    parallelFor(
+        tasks.size(),
+        [&](size_t i) {
+            auto& task = tasks.at(i);
+            auto id    = task.index->getId();
+
+            std::unique_ptr<Archive> archive;
+            try
+            {
+                archive = task.index->loadUncached(task.archive);
+            }
+            catch (const std::exception& e)
+            {
+                if (!options.skipErrors)
+                    throw;
+                LOG(WARNING) << "Skipping archive " << task.archive << " in index " << id << ": " << e.what();
+                failures++;
+                return;
+            }
+
+            auto contents = archive->getFiles();
+            if (options.format == DIRECTORY)
+            {
+                auto directory = std::filesystem::path(path) / std::to_string(id) / std::to_string(task.archive);
+                std::filesystem::create_directories(directory);
+                for (auto&& file: contents)
+                {
+                    std::ofstream out(directory / std::to_string(file.id), std::ios::out | std::ios::binary);
+                    out.write(file.contents.data(), file.contents.size());
+                    if (!out)
+                        throw std::runtime_error("Unable to write exported file");
+                }
+            }
+            else
+            {
+                std::lock_guard lock(packMutex);
+                for (auto&& file: contents)
+                {
+                    pack.write(file.contents.data(), file.contents.size());
+                    records.push_back({ .index           = static_cast<uint32_t>(id),
+                                        .archive         = static_cast<uint32_t>(task.archive),
+                                        .file            = static_cast<uint32_t>(file.id),
+                                        .archiveNameHash = archive->nameHash(),
+                                        .fileNameHash    = static_cast<int32_t>(file.nameHash),
+                                        .offset          = packOffset,
+                                        .length          = file.contents.size() });
+                    packOffset += file.contents.size();
+                }
+                if (!pack)
+                    throw std::runtime_error("Unable to write packed export");
+            }
+
+            archives++;
+            files += contents.size();
+            for (auto&& file: contents)
+                bytes += file.contents.size();
+        },
+        options.threads);
+
+    if (options.format == PACKED)
+    {
+        // Archives complete in any order, so the records are sorted before being written
+        std::sort(records.begin(), records.end(), [](const PackRecord& first, const PackRecord& second) {
+            return std::tie(first.index, first.archive, first.file) < std::tie(second.index, second.archive, second.file);
+        });
+        pack.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(PackRecord));
+
+        PackHeader header{};
+        header.magic        = PACK_MAGIC;
+        header.version      = PACK_VERSION;
+        header.byteOrder    = PACK_BYTE_ORDER_MARK;
+        header.recordCount  = records.size();
+        header.recordOffset = packOffset;
+        pack.seekp(0);
+        pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pack.close();
+        if (!pack)
+            throw std::runtime_error("Unable to write packed export");
+
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+            throw std::runtime_error("Unable to replace packed export");
+    }
+
+    return { archives, files, bytes, failures };
+}
@@ -12,16 +12,21 @@ using namespace rsfs;
  */
 RSBuffer::RSBuffer(std::ifstream& stream)
 {
-    // Seek to the beginning of the stream
+    // Find the length of the stream, and read it in one go
+    stream.seekg(0, std::ios::end);
+    auto length = static_cast<std::streamoff>(stream.tellg());
     stream.seekg(0, std::ios::beg);
+    if (length <= 0)
+        return;
 
-    // Allocate the stream to the buffer
-    buf_ = std::vector<char>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    buf_.resize(length, boost::container::default_init);
+    stream.read(buf_.data(), length);
+    buf_.resize(stream.gcount());
 }
 
 /**
- * Initialises an empty buffer with a fixed size.
- * @param size  The desired size of the buffer.
+ * Initialises an empty buffer with room for a number of bytes.
+ * @param size  The number of bytes to reserve.
  */
 RSBuffer::RSBuffer(size_t size)
 {
@@ -45,11 +50,7 @@ void RSBuffer::seek(size_t pos)
  */
 RSBuffer::RSBuffer(const char* buf, size_t size)
 {
-    buf_.resize(size);
-    for (size_t i = 0; i < size; i++)
-    {
-        buf_.at(i) = buf[i];
-    }
+    buf_.assign(buf, buf + size);
 }
 
 /**
@@ -87,8 +88,7 @@ void RSBuffer::writeByte(char value)
  */
 void RSBuffer::writeBytes(const char* buf, size_t size)
 {
-    for (auto i = 0; i < size; i++)
-        writeByte(buf[i]);
+    buf_.insert(buf_.end(), buf, buf + size);
 }
 
 /**
@@ -97,8 +97,17 @@ void RSBuffer::writeBytes(const char* buf, size_t size)
  */
 void RSBuffer::writeBytes(boost::iterator_range<const char*> range)
 {
-    for (char it: range)
-        writeByte(it);
+    buf_.insert(buf_.end(), range.begin(), range.end());
+}
+
+/**
+ * Writes a two-byte integer value to the buffer.
+ * @param value The value to write.
+ */
+void RSBuffer::writeShort(uint16_t value)
+{
+    writeByte((value >> 8u) & 0xFFu);
+    writeByte(value & 0xFFu);
 }
 
 /**
@@ -113,6 +122,18 @@ void RSBuffer::writeInt(int32_t value)
     writeByte(value & 0xFFu);
 }
 
+/**
+ * Writes a value as a short if it fits in 15 bits, or otherwise as an integer with the top bit set.
+ * @param value The value to write.
+ */
+void RSBuffer::writeSmart(uint32_t value)
+{
+    if (value < 0x8000u)
+        writeShort(value);
+    else
+        writeInt(value | 0x80000000u);
+}
+
 /**
  * Reads a single byte from the buffer.
  * @return  The value.
@@ -132,7 +153,7 @@ RSBuffer RSBuffer::readBytes(size_t size)
     auto position = readerIndex_;
     readerIndex_ += size;
 
-    return { &buf_[position], size };
+    return { buf_.data() + position, size };
 }
 
 /**
@@ -195,7 +216,7 @@ std::string RSBuffer::readString()
  */
 boost::iterator_range<const char*> RSBuffer::readRange(size_t length)
 {
-    auto range = boost::make_iterator_range(&buf_[readerIndex_], &buf_[readerIndex_ + length]);
+    auto range = boost::make_iterator_range(buf_.data() + readerIndex_, buf_.data() + readerIndex_ + length);
     readerIndex_ += length;
     return range;
 }
\ No newline at end of file
@@ -1,80 +1,202 @@
 #include <rsfs/jag/Archive.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
 using namespace rsfs;
 
 /**
  * Initialises this archive based on the archive's metadata
  * @param data  The metadata
+ * @param arena The resource that the metadata was allocated from, if any.
  */
-Archive::Archive(ArchiveData data): data_(std::move(data))
+Archive::Archive(ArchiveData data, std::shared_ptr<std::pmr::memory_resource> arena):
+    arena_(std::move(arena)), data_(std::move(data))
 {
-    // Initialise the file list
-    for (auto&& file: data_.files)
-        files_[file.id] = file;
+    // Reference tables list files in ascending id order, but metadata from elsewhere may not be
+    auto& files = data_.files;
+    auto sorted = std::adjacent_find(files.begin(), files.end(), [](const FileData& first, const FileData& second) {
+                      return first.id >= second.id;
+                  }) == files.end();
+    if (sorted)
+        return;
+
+    std::stable_sort(files.begin(), files.end(),
+                     [](const FileData& first, const FileData& second) { return first.id < second.id; });
+    auto duplicates = std::unique(files.begin(), files.end(),
+                                  [](const FileData& first, const FileData& second) { return first.id == second.id; });
+    files.erase(duplicates, files.end());
 }
 
 /**
- * Reads the data for an archive.
- * @param buf   The decompressed archive data.
+ * Initialises an archive that replaces an unchanged archive from an older reference table.
+ * @param data      The archive's metadata.
+ * @param arena     The resource that the metadata was allocated from, if any.
+ * @param previous  The archive being replaced.
+ */
+Archive::Archive(ArchiveData data, std::shared_ptr<std::pmr::memory_resource> arena, const Archive& previous):
+    Archive(std::move(data), std::move(arena))
+{
+    // The contents are never modified once the archive is marked as loaded, so they can be shared
+    if (previous.loaded())
+    {
+        contents_ = previous.contents_;
+        loaded_.store(true, std::memory_order_release);
+    }
+}
+
+/**
+ * Gets the position of a file in the metadata.
+ * @param id    The file id.
+ * @return      The position of the file.
  */
-void Archive::read(RSBuffer& buf)
+size_t Archive::position(size_t id) const
 {
-    loaded_ = true;  // Mark this archive as loaded
+    auto& files = data_.files;
+    auto it     = std::lower_bound(files.begin(), files.end(), id,
+                                   [](const FileData& file, size_t value) { return file.id < value; });
+    if (it == files.end() || it->id != id)
+        throw std::out_of_range("Archive does not contain file");
+    return static_cast<size_t>(std::distance(files.begin(), it));
+}
 
-    // If there is only one file, set it's contents as this buffer.
-    auto fileCount = files_.size();
+/**
+ * Reads the data for an archive.
+ * @param buf           The decompressed archive data.
+ * @param extraction    When the files in the archive should be extracted.
+ */
+void Archive::read(RSBuffer buf, Extraction extraction)
+{
+    // If there is only one file, its contents are the whole buffer
+    auto fileCount = data_.files.size();
+    auto contents  = std::make_shared<Contents>();
     if (fileCount == 1)
     {
-        auto& file    = files_[0];
-        file.contents = buf;
+        contents->block = std::move(buf);
+        contents->files.assign(1, { contents->block.begin(), contents->block.getSize() });
+        contents_ = std::move(contents);
+        loaded_.store(true, std::memory_order_release);
         return;
     }
 
     // The number of chunks is the last byte
+    if (buf.getSize() == 0)
+        throw std::runtime_error("Archive is empty");
     buf.seek(buf.getSize() - 1);
     auto chunks = buf.readByte() & 0xFFu;
 
-    // Seek to the position of the chunk metadata
-    buf.seek(buf.getSize() - 1 - chunks * fileCount * 4);
-    std::vector<std::vector<int32_t>> chunkSizes(fileCount, std::vector<int32_t>(chunks));
-    std::vector<int32_t> fileSizes(fileCount);
+    // The chunk sizes are stored before the chunk count, for each file within each chunk
+    auto tableSize = chunks * fileCount * 4;
+    if (tableSize + 1 > buf.getSize())
+        throw std::runtime_error("Archive chunk table is truncated");
+    auto tableOffset = buf.getSize() - 1 - tableSize;
+
+    // Files stored in a single chunk are already contiguous, so they can refer to the buffer in place
+    if (extraction == ON_DEMAND || chunks == 1)
+    {
+        mapChunks(buf, chunks, tableOffset, *contents);
+        contents_ = std::move(contents);
+        loaded_.store(true, std::memory_order_release);
+        return;
+    }
 
-    // Read the chunk and file sizes
-    for (auto chunk = 0; chunk < chunks; ++chunk)
+    // Calculate the total size of each file, so that every file can be placed in one block
+    std::vector<size_t> offsets(fileCount + 1);
+    buf.seek(tableOffset);
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
     {
-        auto chunkSize = 0;
-        for (auto id = 0; id < fileCount; ++id)
+        int32_t chunkSize = 0;
+        for (size_t file = 0; file < fileCount; ++file)
         {
-            auto delta = buf.readInt();
-            chunkSize += delta;                       // Size of this chunk
-            chunkSizes.at(id).at(chunk) = chunkSize;  // Store the size of this chunk
-            fileSizes.at(id) += chunkSize;            // Add chunk size to file size
+            chunkSize += static_cast<int32_t>(buf.readInt());
+            if (chunkSize < 0)
+                throw std::runtime_error("Archive chunk has a negative size");
+            offsets.at(file + 1) += chunkSize;
         }
     }
+    for (size_t file = 0; file < fileCount; ++file)
+        offsets.at(file + 1) += offsets.at(file);
 
-    // File contents are at the beginning of the archive
-    buf.seek(0);
-
-    // Prepare to read the file offsets, and their contents
-    std::vector<RSBuffer> contents(fileCount, RSBuffer(0));
+    auto total = offsets.back();
+    if (total > tableOffset)
+        throw std::runtime_error("Archive chunks overrun the chunk table");
 
-    // Read the chunks
-    for (auto chunk = 0; chunk < chunks; ++chunk)
+    // Copy each chunk to the end of its file's contents so far. The chunks are stored in the same order as the
+    // chunk table, and each file's chunks are concatenated.
+    auto& block = contents->block;
+    block.resize(total);
+    std::vector<size_t> written(offsets.begin(), offsets.end() - 1);
+    auto* source = buf.begin();
+    buf.seek(tableOffset);
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
     {
-        for (auto id = 0; id < fileCount; ++id)
+        int32_t chunkSize = 0;
+        for (size_t file = 0; file < fileCount; ++file)
         {
-            auto size       = chunkSizes.at(id).at(chunk);  // Get the size of the file's chunk
-            auto data       = buf.readBytes(size);          // Read the data from the archive
-            contents.at(id) = data;                         // Store the data
+            chunkSize += static_cast<int32_t>(buf.readInt());
+            if (chunkSize > 0)
+                std::memcpy(block.data() + written.at(file), source, chunkSize);
+            written.at(file) += chunkSize;
+            source += chunkSize;
         }
     }
 
-    // Set the contents of the files
-    for (auto i = 0; i < fileCount; i++)
+    // Files are stored in ascending id order
+    contents->files.resize(fileCount);
+    for (size_t file = 0; file < fileCount; ++file)
+        contents->files[file] = { block.begin() + offsets.at(file), offsets.at(file + 1) - offsets.at(file) };
+
+    // Mark this archive as loaded
+    contents_ = std::move(contents);
+    loaded_.store(true, std::memory_order_release);
+}
+
+/**
+ * Parses the chunk table of an archive, leaving its files to be extracted when they are requested.
+ * @param buf           The decompressed archive data, which is moved into the contents.
+ * @param chunks        The number of chunks.
+ * @param tableOffset   The offset of the chunk table.
+ * @param contents      The contents to map the chunks into.
+ */
+void Archive::mapChunks(RSBuffer& buf, size_t chunks, size_t tableOffset, Contents& contents)
+{
+    auto fileCount     = data_.files.size();
+    auto& chunkOffsets = contents.chunkOffsets;
+
+    // Calculate where each chunk starts
+    chunkOffsets.assign(chunks * fileCount + 1, 0);
+    buf.seek(tableOffset);
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
     {
-        auto& file    = files_[i];
-        file.contents = contents.at(i);
+        int32_t chunkSize = 0;
+        for (size_t file = 0; file < fileCount; ++file)
+        {
+            chunkSize += static_cast<int32_t>(buf.readInt());
+            if (chunkSize < 0)
+                throw std::runtime_error("Archive chunk has a negative size");
+
+            auto index                  = chunk * fileCount + file;
+            chunkOffsets.at(index + 1) = chunkOffsets.at(index) + chunkSize;
+        }
     }
+
+    if (chunkOffsets.back() > tableOffset)
+        throw std::runtime_error("Archive chunks overrun the chunk table");
+
+    // The chunks are referred to in place, so only the chunk table is discarded
+    auto& block = contents.block;
+    buf.resize(chunkOffsets.back());
+    block           = std::move(buf);
+    contents.chunks = chunks;
+
+    // A file stored in a single chunk is already contiguous, so it can be referred to in place
+    if (chunks != 1)
+        return;
+
+    contents.files.resize(fileCount);
+    for (size_t file = 0; file < fileCount; ++file)
+        contents.files[file] = { block.begin() + chunkOffsets.at(file), chunkOffsets.at(file + 1) - chunkOffsets.at(file) };
 }
 
 /**
@@ -84,7 +206,43 @@ void Archive::read(RSBuffer& buf)
  */
 RSBuffer Archive::getFileData(size_t id) const
 {
-    return files_.at(id).contents;
+    auto contents = file(id);
+    return { contents.data(), contents.size() };
+}
+
+/**
+ * Gets the contents of a specific file, extracting it if it hasn't been extracted yet.
+ * @param id    The file id.
+ * @return      The file contents.
+ */
+std::span<const char> Archive::file(size_t id) const
+{
+    auto position = this->position(id);
+    if (!contents_)
+        return {};
+
+    // Files that were split eagerly, or that are stored in a single chunk, already refer to their contents
+    auto& loaded = *contents_;
+    if (loaded.chunks <= 1)
+        return position < loaded.files.size() ? loaded.files[position] : std::span<const char>();
+
+    std::lock_guard lock(loaded.extractMutex);
+    auto extracted = loaded.extracted.find(id);
+    if (extracted != loaded.extracted.end())
+        return { extracted->second.data(), extracted->second.size() };
+
+    // Concatenate the file's chunks
+    auto fileCount = data_.files.size();
+    std::vector<char> contents;
+    for (size_t chunk = 0; chunk < loaded.chunks; ++chunk)
+    {
+        auto index = chunk * fileCount + position;
+        contents.insert(contents.end(), loaded.block.begin() + loaded.chunkOffsets.at(index),
+                        loaded.block.begin() + loaded.chunkOffsets.at(index + 1));
+    }
+
+    auto& stored = loaded.extracted[id] = std::move(contents);
+    return { stored.data(), stored.size() };
 }
 
 /**
@@ -93,9 +251,8 @@ RSBuffer Archive::getFileData(size_t id) const
  */
 std::vector<FileData> Archive::getFiles() const
 {
-    std::vector<FileData> files;
-    std::transform(files_.begin(), files_.end(), std::back_inserter(files), [](auto& kv) { return kv.second; });
-    std::sort(files.begin(), files.end(),
-              [](const FileData& first, const FileData& second) { return first.id < second.id; });
+    std::vector<FileData> files(data_.files.begin(), data_.files.end());
+    for (auto&& file: files)
+        file.contents = this->file(file.id);
     return files;
 }
\ No newline at end of file
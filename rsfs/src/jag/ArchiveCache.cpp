@@ -0,0 +1,79 @@
+#include <rsfs/jag/ArchiveCache.hpp>
+
+using namespace rsfs;
+
+/**
+ * Creates an archive cache.
+ * @param capacity  The maximum number of archives to keep.
+ */
+ArchiveCache::ArchiveCache(size_t capacity): capacity_(capacity)
+{
+    positions_.reserve(capacity);
+}
+
+/**
+ * Gets an archive from the cache, if its checksum and revision match the metadata it is expected to have.
+ * @param index     The index id.
+ * @param metadata  The current metadata of the archive.
+ * @return          The archive, or null if it isn't cached or is out of date.
+ */
+std::shared_ptr<const Archive> ArchiveCache::get(size_t index, const ArchiveData& metadata)
+{
+    std::lock_guard lock(mutex_);
+    auto it = positions_.find(key(index, metadata.id));
+    if (it == positions_.end())
+        return nullptr;
+
+    // Drop archives that have changed since they were cached
+    auto& archive = it->second->archive;
+    if (archive->checksum() != metadata.crc || archive->revision() != metadata.revision)
+    {
+        entries_.erase(it->second);
+        positions_.erase(it);
+        return nullptr;
+    }
+
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return archive;
+}
+
+/**
+ * Adds an archive to the cache, evicting the least recently used archive if the cache is full.
+ * @param index     The index id.
+ * @param archive   The archive.
+ */
+void ArchiveCache::put(size_t index, std::shared_ptr<const Archive> archive)
+{
+    if (capacity_ == 0)
+        return;
+
+    auto archiveKey = key(index, archive->id());
+
+    std::lock_guard lock(mutex_);
+    auto it = positions_.find(archiveKey);
+    if (it != positions_.end())
+    {
+        it->second->archive = std::move(archive);
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+
+    if (entries_.size() >= capacity_)
+    {
+        positions_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+
+    entries_.push_front({ archiveKey, std::move(archive) });
+    positions_.emplace(archiveKey, entries_.begin());
+}
+
+/**
+ * Removes every archive from the cache.
+ */
+void ArchiveCache::clear()
+{
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    positions_.clear();
+}
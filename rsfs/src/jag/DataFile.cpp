@@ -1,30 +1,44 @@
+#include "util/Advise.hpp"
+
 #include <rsfs/jag/DataFile.hpp>
+#include <rsfs/metrics/Metrics.hpp>
 
-using namespace rsfs;
+#include <algorithm>
+#include <chrono>
 
-/**
- * The size of a data sector.
- */
-constexpr const auto SECTOR_SIZE = 520;
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace rsfs;
 
 /**
- * The size of a sector with a small header
+ * Opens a data file.
+ * @param path  The path to the data file.
+ * @param hints How the data file will be read.
  */
-constexpr const auto SMALL_HEADER_SIZE = 8;
+DataFile::DataFile(std::string path, IoHints hints): path_(std::move(path)), hints_(hints)
+{
+    open();
+}
 
 /**
- * The size of a sector with a large header (to support archive ids > 65535)
+ * Closes the data file.
  */
-constexpr const auto LARGE_HEADER_SIZE = 10;
+DataFile::~DataFile()
+{
+    close();
+}
 
 /**
- * Initialises the data file based on the file stream.
- * @param stream    The input stream
+ * Reopens the data file.
  */
-DataFile::DataFile(std::ifstream stream): stream_(std::move(stream))
+void DataFile::reopen()
 {
-    // Set the length of the data file
-    length_ = stream_.tellg();
+    std::unique_lock lock(mutex_);
+    close();
+    open();
 }
 
 /**
@@ -38,41 +52,50 @@ DataFile::DataFile(std::ifstream stream): stream_(std::move(stream))
 RSBuffer DataFile::read(size_t index, size_t archive, size_t sector, size_t length)
 {
     // Validate the sector input
-    if (sector <= 0 || length_ / SECTOR_SIZE < sector)
+    if (sector <= 0 || length_.load(std::memory_order_relaxed) / SECTOR_SIZE < sector)
     {
         throw std::runtime_error("Sector out of bounds");
     }
 
+    // If we should read this as a large sector
+    auto largeSector = archive > 0xFFFF;
+    auto headerSize  = largeSector ? LARGE_HEADER_SIZE : SMALL_HEADER_SIZE;
+    auto dataSize    = SECTOR_SIZE - headerSize;
+    auto sectorCount = (length + dataSize - 1) / dataSize;
+
     // The temporary buffer to read into
     char tmp[SECTOR_SIZE];
     RSBuffer buffer(length);
 
-    // Read the data, starting from the sector specified
-    for (int part = 0, readByteCount = 0, nextSector; length > readByteCount; sector = nextSector)
-    {
-        // Seek to the sector
-        stream_.seekg(SECTOR_SIZE * sector, std::ios::beg);
+    // Reads may run at the same time, but not while the file is being reopened
+    std::shared_lock lock(mutex_);
 
-        // If we should read this as a large sector
-        auto largeSector = archive > 0xFFFF;
-        auto headerSize  = largeSector ? LARGE_HEADER_SIZE : SMALL_HEADER_SIZE;
-        auto dataSize    = SECTOR_SIZE - headerSize;
+    // The run of sectors that has been requested ahead of the chain
+    size_t requestedStart = 0;
+    size_t requestedEnd   = 0;
 
-        // Read the sector into the temporary buffer
-        auto bytesRead = stream_.readsome(tmp, SECTOR_SIZE);
-        if (bytesRead != SECTOR_SIZE)
+    // Read the data, starting from the sector specified
+    for (size_t part = 0, readByteCount = 0, nextSector; length > readByteCount; sector = nextSector)
+    {
+        // When the chain leaves the requested run, request the sectors after this one, assuming that the chain
+        // continues contiguously, so that they are read while this one is processed
+        auto remaining = sectorCount - part;
+        if (hints_.readaheadSectors > 0 && remaining > 1 && (sector < requestedStart || sector >= requestedEnd))
         {
-            throw std::runtime_error("Short read");
+            requestedStart = sector;
+            requestedEnd   = sector + std::min(hints_.readaheadSectors, remaining);
+            requestSectors(requestedStart, requestedEnd - requestedStart);
         }
 
-        // Wrap the bytes in a RSBuffer
-        RSBuffer buf(tmp, SECTOR_SIZE);
+        // Read the sector into the temporary buffer
+        auto start = std::chrono::steady_clock::now();
+        readSector(sector, tmp);
+        Metrics::recordSectorRead(std::chrono::steady_clock::now() - start);
+        Metrics::increment(index, SECTORS_READ);
 
         // Read the header
-        auto currentArchive = largeSector ? buf.readInt() : buf.readShort();
-        auto currentPart    = buf.readShort() & 0xFFFF;
-        nextSector          = buf.readTriByte();
-        auto currentIndex   = buf.readByte() & 0xFFu;
+        auto header = decodeHeader(tmp, largeSector);
+        nextSector  = header.nextSector;
 
         // Write the bytes into our buffer
         buffer.writeBytes(&tmp[headerSize], dataSize);
@@ -80,6 +103,126 @@ RSBuffer DataFile::read(size_t index, size_t archive, size_t sector, size_t leng
         ++part;
     }
 
+    Metrics::increment(index, ARCHIVES_READ);
+    Metrics::increment(index, BYTES_READ, length);
+
     buffer.resize(length);
     return buffer;
-}
\ No newline at end of file
+}
+
+/**
+ * Asks the operating system to read a run of sectors into the page cache in the background.
+ * @param sector    The first sector.
+ * @param count     The number of sectors.
+ */
+void DataFile::prefetch(size_t sector, size_t count)
+{
+    std::shared_lock lock(mutex_);
+    requestSectors(sector, count);
+}
+
+/**
+ * Decodes the header of a sector.
+ * @param sector        The sector data.
+ * @param largeSector   If the sector has a large header.
+ * @return              The sector header.
+ */
+SectorHeader DataFile::decodeHeader(const char* sector, bool largeSector)
+{
+    RSBuffer buf(sector, largeSector ? LARGE_HEADER_SIZE : SMALL_HEADER_SIZE);
+
+    SectorHeader header;
+    header.archive    = largeSector ? buf.readInt() : buf.readShort();
+    header.part       = buf.readShort();
+    header.nextSector = buf.readTriByte();
+    header.index      = buf.readByte();
+    return header;
+}
+
+/**
+ * Encodes the header of a sector.
+ * @param header        The sector header.
+ * @param sector        The sector data to write the header to.
+ * @param largeSector   If the sector has a large header.
+ */
+void DataFile::encodeHeader(const SectorHeader& header, char* sector, bool largeSector)
+{
+    RSBuffer buf(LARGE_HEADER_SIZE);
+    if (largeSector)
+        buf.writeInt(header.archive);
+    else
+        buf.writeShort(header.archive);
+    buf.writeShort(header.part);
+    buf.writeByte(header.nextSector >> 16);
+    buf.writeByte(header.nextSector >> 8);
+    buf.writeByte(header.nextSector);
+    buf.writeByte(header.index);
+    std::copy(buf.begin(), buf.end(), sector);
+}
+
+/**
+ * Opens the data file and applies the hints to it.
+ */
+void DataFile::open()
+{
+#ifdef __linux__
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0)
+        throw std::runtime_error("Unable to open data file");
+    length_ = static_cast<size_t>(::lseek(fd_, 0, SEEK_END));
+
+    adviseFile(fd_, hints_.pattern);
+#else
+    stream_.clear();
+    stream_.open(path_, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!stream_)
+        throw std::runtime_error("Unable to open data file");
+    length_ = stream_.tellg();
+#endif
+}
+
+/**
+ * Closes the data file.
+ */
+void DataFile::close()
+{
+#ifdef __linux__
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+#else
+    stream_.close();
+#endif
+}
+
+/**
+ * Reads a whole sector.
+ * @param sector    The sector.
+ * @param out       The array to read the sector into.
+ */
+void DataFile::readSector(size_t sector, char* out)
+{
+#ifdef __linux__
+    auto bytesRead = ::pread(fd_, out, SECTOR_SIZE, static_cast<off_t>(SECTOR_SIZE * sector));
+#else
+    std::lock_guard lock(streamMutex_);
+    stream_.seekg(SECTOR_SIZE * sector, std::ios::beg);
+    auto bytesRead = stream_.readsome(out, SECTOR_SIZE);
+#endif
+    if (bytesRead != SECTOR_SIZE)
+    {
+        throw std::runtime_error("Short read");
+    }
+}
+
+/**
+ * Asks the operating system to read a run of sectors in the background.
+ * @param sector    The first sector.
+ * @param count     The number of sectors.
+ */
+void DataFile::requestSectors(size_t sector, size_t count)
+{
+#ifdef __linux__
+    requestRange(fd_, SECTOR_SIZE * sector, SECTOR_SIZE * count);
+#endif
+}
@@ -1,17 +1,16 @@
+#include "util/BigEndian.hpp"
+
 #include <rsfs/compression/Compression.hpp>
 #include <rsfs/jag/IndexFile.hpp>
+#include <rsfs/metrics/Metrics.hpp>
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cstring>
 
 using namespace rsfs;
 
-/**
- * The size of an entry in an index file.
- */
-constexpr auto ENTRY_SIZE = 6;
-
 /**
  * The settings flags
  */
@@ -19,146 +18,348 @@ constexpr const auto FLAG_NAMED     = 0x1u;
 constexpr const auto FLAG_WHIRLPOOL = 0x2u;
 
 /**
- * Creates an index with a specific metadata stream.
- * @param stream    The metadata file stream for this index.
- * @param dataFile  The main data file.
- * @param id        The data of this index.
+ * The initial size of the metadata arena of an index, per byte of its reference table. Files take at least two
+ * bytes of the table and their metadata takes 32 bytes, so this covers most tables in a single allocation, and the
+ * arena grows geometrically for the rest.
  */
-IndexFile::IndexFile(std::ifstream stream, DataFile* dataFile, size_t id)
-    : stream_(std::move(stream)), dataFile_(dataFile), id_(id)
+constexpr const auto ARENA_BYTES_PER_TABLE_BYTE = 8;
+
+namespace
 {
-    // Calculate the number of entries
-    entryCount_ = stream_.tellg() / ENTRY_SIZE;
-    stream_.seekg(std::ios::beg);
+    /**
+     * Checks if an archive is unchanged between two reference tables.
+     * @param previous  The metadata of the archive in the older table.
+     * @param next      The metadata of the archive in the newer table.
+     * @return          If the archive is unchanged.
+     */
+    bool unchanged(const ArchiveData& previous, const ArchiveData& next)
+    {
+        return previous.crc == next.crc && previous.revision == next.revision && previous.nameHash == next.nameHash &&
+               previous.whirlpool == next.whirlpool && previous.files.size() == next.files.size();
+    }
 }
 
 /**
- * Destroys the resources used by this index.
+ * Creates an index whose archives are read from a store.
+ * @param store The store.
+ * @param id    The id of this index.
  */
-IndexFile::~IndexFile()
+IndexFile::IndexFile(Store* store, size_t id): store_(store), id_(id)
 {
-    for (auto&& archive: archives_)
-        delete archive.second;
 }
 
 /**
- * Reads the entry data for a specific id from this index.
- * @param id    The entry id.
- * @return      The entry data.
+ * Destroys the resources used by this index.
  */
-IndexEntry IndexFile::read(size_t id)
-{
-    stream_.seekg(id * ENTRY_SIZE, std::ios::beg);
-    char tmp[ENTRY_SIZE];
+IndexFile::~IndexFile() = default;
 
-    auto bytesRead = stream_.readsome(tmp, ENTRY_SIZE);
-    if (bytesRead != ENTRY_SIZE)
-    {
-        throw std::runtime_error("Short read");
-    }
+/**
+ * Sets the function used to load this index the first time its archives or metadata are accessed.
+ * @param loader    The loader.
+ */
+void IndexFile::setLoader(std::function<void(IndexFile&)> loader)
+{
+    loader_ = std::move(loader);
+}
 
-    RSBuffer buf(tmp, ENTRY_SIZE);
-    auto length = buf.readTriByte();
-    auto sector = buf.readTriByte();
+/**
+ * Loads this index through its loader, if it hasn't been loaded yet.
+ */
+void IndexFile::ensureLoaded() const
+{
+    if (!loader_)
+        return;
 
-    return { length, sector };
+    // The loader populates the index, which is never itself constructed as const
+    std::call_once(loaded_, [this] { loader_(const_cast<IndexFile&>(*this)); });
 }
 
 /**
  * Parses the data for this index from a decompressed buffer.
  * @param buf   The buffer.
+ * @return      The number of archives that were added, changed or removed.
  */
-void IndexFile::load(RSBuffer& buf)
+size_t IndexFile::load(RSBuffer& buf)
 {
-    protocol_ = buf.readByte();
+    size_t protocol = buf.readByte();
 
     // If the protocol isn't valid, throw an error
-    if (protocol_ < 5 || protocol_ > 7)
+    if (protocol < 5 || protocol > 7)
     {
         throw std::runtime_error("Unsupported protocol");
     }
 
     // A helper function to read a "smart" data-type
-    auto readSmart = [&](RSBuffer& buf) { return protocol_ >= 7 ? buf.readSmart() : buf.readShort(); };
+    auto readSmart = [&](RSBuffer& buf) { return protocol >= 7 ? buf.readSmart() : buf.readShort(); };
+
+    // Each column of the table is decoded in bulk into this scratch space, and then copied into the metadata
+    std::vector<uint32_t> values;
+    auto readInts = [&](size_t count) {
+        if (count > buf.getRemaining() / sizeof(uint32_t))
+            throw std::runtime_error("Reference table is truncated");
+        values.resize(count);
+        decodeInts(buf.readRange(count * sizeof(uint32_t)).begin(), count, values.data());
+    };
+
+    // Smarts are fixed width shorts before protocol 7, so only the later protocols have to be read one at a time
+    auto readSmarts = [&](size_t count) {
+        if (count > buf.getRemaining() / sizeof(uint16_t))
+            throw std::runtime_error("Reference table is truncated");
+        values.resize(count);
+        if (protocol < 7)
+            decodeShorts(buf.readRange(count * sizeof(uint16_t)).begin(), count, values.data());
+        else
+            std::generate(values.begin(), values.end(), [&] { return buf.readSmart(); });
+    };
 
     // Read the revision, if applicable
-    if (protocol_ >= 6)
-        revision_ = buf.readInt();
+    size_t revision = 0;
+    if (protocol >= 6)
+        revision = buf.readInt();
 
     // Read the settings mask
-    auto settings = buf.readByte() & 0xFFu;
-    named_        = (FLAG_NAMED & settings) != 0;
-    whirlpool_    = (FLAG_WHIRLPOOL & settings) != 0;
+    auto settings  = buf.readByte() & 0xFFu;
+    auto named     = (FLAG_NAMED & settings) != 0;
+    auto whirlpool = (FLAG_WHIRLPOOL & settings) != 0;
 
-    // Read the number of archives
-    auto archiveCount = readSmart(buf);
-    std::vector<ArchiveData> archiveData;
-    archiveData.resize(archiveCount);
+    // The file metadata of every archive is allocated from one arena, which is released all at once when neither
+    // the table nor any of its archives refer to it
+    auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>(
+        std::max<size_t>(buf.getRemaining(), 1) * ARENA_BYTES_PER_TABLE_BYTE);
 
-    // The last archive id
-    size_t lastArchiveId = 0;
-    for (auto i = 0; i < archiveCount; i++)
-    {
-        size_t id         = lastArchiveId += readSmart(buf);
-        archiveData.at(i) = ArchiveData{ .id = id };
-    }
+    // Read the number of archives, and their delta encoded ids
+    size_t archiveCount = readSmart(buf);
+    readSmarts(archiveCount);
+    prefixSum(values.data(), archiveCount);
+
+    std::vector<ArchiveData> archiveData;
+    archiveData.reserve(archiveCount);
+    for (size_t i = 0; i < archiveCount; i++)
+        archiveData.push_back(ArchiveData{ .id = values[i], .files = std::pmr::vector<FileData>(arena.get()) });
 
     // If this is a named index, we need to read the name hashes
-    if (named_)
+    if (named)
     {
-        for (auto&& archive: archiveData)
-            archive.nameHash = buf.readInt();
+        readInts(archiveCount);
+        for (size_t i = 0; i < archiveCount; i++)
+            archiveData[i].nameHash = static_cast<int>(values[i]);
     }
 
     // If the archives have a whirlpool digest
-    if (whirlpool_)
+    if (whirlpool)
     {
-        for (auto&& archive: archiveData)
-        {
-            auto data = buf.readBytes(WHIRLPOOL_SIZE);
-            std::memcpy(archive.whirlpool.data(), data.begin(), WHIRLPOOL_SIZE);
-        }
+        if (archiveCount > buf.getRemaining() / WHIRLPOOL_SIZE)
+            throw std::runtime_error("Reference table is truncated");
+
+        auto* digests = buf.readRange(archiveCount * WHIRLPOOL_SIZE).begin();
+        for (size_t i = 0; i < archiveCount; i++)
+            std::memcpy(archiveData[i].whirlpool.data(), digests + i * WHIRLPOOL_SIZE, WHIRLPOOL_SIZE);
     }
 
     // Read the checksums for each archive
-    for (auto&& archive: archiveData)
-        archive.crc = buf.readInt();
+    readInts(archiveCount);
+    for (size_t i = 0; i < archiveCount; i++)
+        archiveData[i].crc = static_cast<int>(values[i]);
 
     // Read the revisions for each archive
-    for (auto&& archive: archiveData)
-        archive.revision = buf.readInt();
+    readInts(archiveCount);
+    for (size_t i = 0; i < archiveCount; i++)
+        archiveData[i].revision = values[i];
 
     // Read the file count for each archive
-    for (auto&& archive: archiveData)
+    size_t fileCount = 0;
+    readSmarts(archiveCount);
+    for (size_t i = 0; i < archiveCount; i++)
     {
-        archive.fileCount = readSmart(buf);
-        archive.files.resize(archive.fileCount);
+        archiveData[i].fileCount = values[i];
+        archiveData[i].files.resize(values[i]);
+        fileCount += values[i];
     }
 
-    // Read the file ids for each archive
+    // Read the file ids for every archive at once, and decode the ids of each archive separately
+    readSmarts(fileCount);
+    size_t offset = 0;
     for (auto&& archive: archiveData)
+    {
+        prefixSum(values.data() + offset, archive.fileCount);
+        for (size_t i = 0; i < archive.fileCount; i++)
+            archive.files[i] = FileData{ .id = values[offset + i] };
+        offset += archive.fileCount;
+    }
+
+    // Read the name hash for each file
+    if (named)
+    {
+        readInts(fileCount);
+        offset = 0;
+        for (auto&& archive: archiveData)
+        {
+            for (auto&& file: archive.files)
+                file.nameHash = values[offset++];
+        }
+    }
+
+    return load(protocol, revision, named, whirlpool, std::move(archiveData), std::move(arena));
+}
+
+/**
+ * Encodes a reference table in the format that load() parses.
+ * @param protocol  The protocol of the reference table.
+ * @param revision  The revision of the index.
+ * @param named     If the archives have name hashes.
+ * @param whirlpool If the archives have whirlpool digests.
+ * @param archives  The archive metadata, sorted by id.
+ * @return          The decompressed reference table.
+ */
+RSBuffer IndexFile::encode(size_t protocol, size_t revision, bool named, bool whirlpool,
+                           const std::vector<ArchiveData>& archives)
+{
+    if (protocol < 5 || protocol > 7)
+        throw std::runtime_error("Unsupported protocol");
+
+    RSBuffer buf;
+    auto writeSmart = [&](size_t value) {
+        if (protocol >= 7)
+            buf.writeSmart(value);
+        else
+            buf.writeShort(value);
+    };
+
+    buf.writeByte(protocol);
+    if (protocol >= 6)
+        buf.writeInt(revision);
+    buf.writeByte((named ? FLAG_NAMED : 0) | (whirlpool ? FLAG_WHIRLPOOL : 0));
+
+    // The archive ids are delta encoded
+    writeSmart(archives.size());
+    size_t lastArchiveId = 0;
+    for (auto&& archive: archives)
+    {
+        writeSmart(archive.id - lastArchiveId);
+        lastArchiveId = archive.id;
+    }
+
+    if (named)
+    {
+        for (auto&& archive: archives)
+            buf.writeInt(archive.nameHash);
+    }
+
+    if (whirlpool)
+    {
+        for (auto&& archive: archives)
+            buf.writeBytes(archive.whirlpool.data(), WHIRLPOOL_SIZE);
+    }
+
+    for (auto&& archive: archives)
+        buf.writeInt(archive.crc);
+
+    for (auto&& archive: archives)
+        buf.writeInt(archive.revision);
+
+    for (auto&& archive: archives)
+        writeSmart(archive.files.size());
+
+    for (auto&& archive: archives)
     {
         size_t lastFileId = 0;
-        for (auto i = 0; i < archive.fileCount; i++)
+        for (auto&& file: archive.files)
         {
-            auto id             = lastFileId += readSmart(buf);
-            archive.files.at(i) = FileData{ .id = id };
+            writeSmart(file.id - lastFileId);
+            lastFileId = file.id;
         }
     }
 
-    // Read the name hash for each file
-    if (named_)
+    if (named)
     {
-        for (auto&& archive: archiveData)
+        for (auto&& archive: archives)
         {
             for (auto&& file: archive.files)
-                file.nameHash = buf.readInt();
+                buf.writeInt(file.nameHash);
         }
     }
+    return buf;
+}
 
-    // Create the archives
-    for (auto&& archive: archiveData)
-        archives_[archive.id] = new Archive(archive);
+/**
+ * Loads this index from metadata that has already been parsed.
+ * @param protocol  The protocol of the reference table.
+ * @param revision  The revision of the index.
+ * @param named     If the archives have name hashes.
+ * @param whirlpool If the archives have whirlpool digests.
+ * @param archives  The archive metadata.
+ * @param arena     The resource that the file metadata was allocated from, if any.
+ * @return          The number of archives that were added, changed or removed.
+ */
+size_t IndexFile::load(size_t protocol, size_t revision, bool named, bool whirlpool, std::vector<ArchiveData> archives,
+                       std::shared_ptr<std::pmr::memory_resource> arena)
+{
+    std::lock_guard lock(tableMutex_);
+    auto* previous = current_.load(std::memory_order_acquire);
+
+    // The archive map is allocated from the same arena as the metadata, if there is one
+    auto next = std::make_unique<ReferenceTable>(arena ? arena : std::make_shared<std::pmr::monotonic_buffer_resource>());
+
+    next->protocol  = protocol;
+    next->revision  = revision;
+    next->named     = named;
+    next->whirlpool = whirlpool;
+
+    // Keep the contents of the archives that haven't changed, and create the others. Unchanged archives still refer
+    // to the new metadata, so that the previous table's arena is freed once that table is reclaimed.
+    size_t changed = 0;
+    for (auto&& archive: archives)
+    {
+        if (previous)
+        {
+            auto it = previous->archives.find(archive.id);
+            if (it != previous->archives.end() && unchanged(it->second->metadata(), archive))
+            {
+                next->archives[archive.id] = std::make_shared<Archive>(std::move(archive), arena, *it->second);
+                continue;
+            }
+        }
+
+        changed++;
+        next->archives[archive.id] = std::make_shared<Archive>(std::move(archive), arena);
+    }
+
+    // Archives that were removed also count as changes
+    if (previous)
+    {
+        for (auto&& [archiveId, archive]: previous->archives)
+        {
+            if (!next->archives.contains(archiveId))
+                changed++;
+        }
+    }
+
+    current_.store(next.get(), std::memory_order_release);
+    tables_.push_back(std::move(next));
+    return changed;
+}
+
+/**
+ * Frees the reference tables that have been replaced by a newer table.
+ */
+void IndexFile::reclaim()
+{
+    std::lock_guard lock(tableMutex_);
+    auto* current = current_.load(std::memory_order_acquire);
+    std::erase_if(tables_, [current](auto& table) { return table.get() != current; });
+}
+
+/**
+ * Gets the current reference table, loading this index if it hasn't been loaded yet.
+ * @return  The reference table.
+ */
+const IndexFile::ReferenceTable& IndexFile::table() const
+{
+    static const ReferenceTable EMPTY;
+
+    ensureLoaded();
+    auto* table = current_.load(std::memory_order_acquire);
+    return table ? *table : EMPTY;
 }
 
 /**
@@ -168,29 +369,174 @@ void IndexFile::load(RSBuffer& buf)
  */
 RSBuffer IndexFile::readArchive(size_t archive)
 {
-    auto entry = read(archive);
-    return dataFile_->read(id_, archive, entry.sector, entry.length);
+    return store_->read(id_, archive);
 }
 
 /**
- * Gets an archive with a specific id
+ * Gets an archive with a specific id, loading it if it hasn't been loaded yet.
  * @param archiveId The archive id
  * @return          The archive
  */
 Archive& IndexFile::getArchive(size_t archiveId)
 {
-    auto* archive = archives_[archiveId];
+    auto* archive = table().archives.at(archiveId).get();
     assert(archive);
 
-    if (!archive->loaded())
+    if (archive->loaded())
+    {
+        Metrics::increment(id_, CACHE_HITS);
+        return *archive;
+    }
+
+    // Only one thread may load an archive, and another thread may have loaded it while we were waiting
+    std::lock_guard lock(archiveLocks_[archiveId % ARCHIVE_LOCK_COUNT]);
+    if (archive->loaded())
     {
-        auto data         = readArchive(archiveId);
-        auto decompressed = Compression::decompress(data);
-        archive->read(decompressed);
+        Metrics::increment(id_, CACHE_HITS);
+        return *archive;
     }
+    Metrics::increment(id_, CACHE_MISSES);
+
+    auto decompressed = decompressArchive(archiveId);
+    archive->read(std::move(decompressed), extraction_);
     return *archive;
 }
 
+/**
+ * Reads an archive without caching it in this index.
+ * @param archiveId The archive id.
+ * @return          The archive, with every file extracted.
+ */
+std::unique_ptr<Archive> IndexFile::loadUncached(size_t archiveId)
+{
+    auto archive      = std::make_unique<Archive>(archiveData(archiveId));
+    auto decompressed = decompressArchive(archiveId);
+    archive->read(std::move(decompressed));
+    return archive;
+}
+
+/**
+ * Gets an archive that the caller shares ownership of, without keeping it in this index.
+ * @param archiveId The archive id.
+ * @return          The archive, with every file extracted.
+ */
+std::shared_ptr<const Archive> IndexFile::acquireArchive(size_t archiveId)
+{
+    auto resident = table().archives.at(archiveId);
+    if (resident->loaded())
+    {
+        Metrics::increment(id_, CACHE_HITS);
+        return resident;
+    }
+
+    if (hotCache_)
+    {
+        if (auto cached = hotCache_->get(id_, resident->metadata()))
+        {
+            Metrics::increment(id_, CACHE_HITS);
+            return cached;
+        }
+    }
+    Metrics::increment(id_, CACHE_MISSES);
+
+    std::shared_ptr<const Archive> archive = loadUncached(archiveId);
+    if (hotCache_)
+        hotCache_->put(id_, archive);
+    return archive;
+}
+
+/**
+ * Reads, deciphers and decompresses an archive.
+ * @param archiveId The archive id.
+ * @return          The decompressed archive data.
+ */
+RSBuffer IndexFile::decompressArchive(size_t archiveId)
+{
+    // Containers that the store holds in memory are decompressed where they are, unless they have to be deciphered
+    RSBuffer data;
+    auto view = encrypted(archiveId) ? std::nullopt : store_->view(id_, archiveId);
+    if (!view)
+    {
+        data = readArchive(archiveId);
+        decipher(archiveId, data);
+    }
+
+    RSBuffer decompressed;
+    try
+    {
+        decompressed = view ? Compression::decompress(*view) : Compression::decompress(data);
+    }
+    catch (...)
+    {
+        Metrics::increment(id_, DECOMPRESSION_FAILURES);
+        throw;
+    }
+    Metrics::increment(id_, BYTES_DECOMPRESSED, decompressed.getSize());
+    return decompressed;
+}
+
+/**
+ * Sets the key store used to decipher encrypted archives.
+ * @param keys  The key store, or null if archives should not be deciphered.
+ */
+void IndexFile::setKeys(const XteaKeyStore* keys)
+{
+    keys_ = keys;
+}
+
+/**
+ * Sets when the files in this index's archives are extracted.
+ * @param extraction    When files should be extracted.
+ */
+void IndexFile::setExtraction(Extraction extraction)
+{
+    extraction_ = extraction;
+}
+
+/**
+ * Sets the cache that recently acquired archives are kept in.
+ * @param cache The cache, or null if acquired archives should not be cached.
+ */
+void IndexFile::setHotCache(ArchiveCache* cache)
+{
+    hotCache_ = cache;
+}
+
+/**
+ * Deciphers an archive container read from this index in place, if there is a key for the archive.
+ * @param archiveId The archive id.
+ * @param container The compressed archive container.
+ */
+void IndexFile::decipher(size_t archiveId, RSBuffer& container) const
+{
+    if (auto* key = this->key(archiveId))
+        Xtea::decipherContainer(container, *key);
+}
+
+/**
+ * Checks if there is a key for an archive, meaning that its container is encrypted.
+ * @param archiveId The archive id.
+ * @return          If the archive is encrypted.
+ */
+bool IndexFile::encrypted(size_t archiveId) const
+{
+    return key(archiveId) != nullptr;
+}
+
+/**
+ * Gets the key that an archive's container is encrypted with.
+ * @param archiveId The archive id.
+ * @return          The key, or null if the archive isn't encrypted.
+ */
+const XteaKey* IndexFile::key(size_t archiveId) const
+{
+    if (!keys_)
+        return nullptr;
+
+    auto* key = keys_->find(id_, archiveId, table().archives.at(archiveId)->nameHash());
+    return key && !Xtea::isZero(*key) ? key : nullptr;
+}
+
 /**
  * Gets the data for a specific file in an archive.
  * @param archive   The archive id.
@@ -199,6 +545,30 @@ Archive& IndexFile::getArchive(size_t archiveId)
  */
 RSBuffer IndexFile::data(size_t archiveId, int32_t fileId)
 {
-    auto archive = getArchive(archiveId);
+    auto& archive = getArchive(archiveId);
     return archive.getFileData(fileId);
+}
+
+/**
+ * Gets the metadata of an archive, without loading it.
+ * @param archiveId The archive id.
+ * @return          The archive metadata.
+ */
+const ArchiveData& IndexFile::archiveData(size_t archiveId) const
+{
+    return table().archives.at(archiveId)->metadata();
+}
+
+/**
+ * Gets the ids of all of the archives in this index.
+ * @return  The sorted archive ids.
+ */
+std::vector<size_t> IndexFile::archiveIds() const
+{
+    auto& archives = table().archives;
+    std::vector<size_t> ids;
+    ids.reserve(archives.size());
+    for (auto&& archive: archives)
+        ids.push_back(archive.first);
+    return ids;
 }
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "util/Advise.hpp"
+
+#include <rsfs/RSFileSystem.hpp>
+#include <rsfs/jag/MetadataSnapshot.hpp>
+
+#include <boost/crc.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace rsfs;
+
+/**
+ * The magic value at the start of a metadata snapshot.
+ */
+constexpr const std::array<char, 8> METADATA_MAGIC = { 'R', 'S', 'F', 'S', 'M', 'E', 'T', 'A' };
+
+/**
+ * The version of the snapshot format. This must be incremented whenever the layout changes.
+ */
+constexpr const uint32_t METADATA_VERSION = 2;
+
+/**
+ * A value written in native byte order, used to reject snapshots written on a host with a different byte order.
+ */
+constexpr const uint32_t METADATA_BYTE_ORDER_MARK = 0x01020304;
+
+namespace
+{
+    /**
+     * The header at the start of a metadata snapshot. The index, archive and file records follow it, in that order.
+     */
+    struct MetadataHeader
+    {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t indexCount;
+        uint64_t archiveCount;
+        uint64_t fileCount;
+    };
+}
+
+/**
+ * Writes the reference tables of every index in a filesystem to a snapshot file.
+ * @param fs    The filesystem.
+ * @param path  The path to write the snapshot to.
+ */
+void MetadataSnapshot::write(RSFileSystem& fs, const std::string& path)
+{
+    std::vector<IndexRecord> indices;
+    std::vector<ArchiveRecord> archives;
+    std::vector<FileRecord> files;
+
+    for (auto* index: fs.indices_)
+    {
+        // Tag the index with the current state of its reference table
+        auto table = fs.readIndex(index->getId());
+        boost::crc_32_type checksum;
+        checksum.process_block(table.begin(), table.end());
+
+        IndexRecord record{};
+        record.length       = table.getSize();
+        record.crc          = static_cast<int32_t>(checksum.checksum());
+        record.revision     = index->revision();
+        record.protocol     = index->protocol();
+        record.named        = index->named();
+        record.whirlpool    = index->whirlpool();
+        record.present      = 1;
+        record.firstArchive = archives.size();
+
+        for (auto archiveId: index->archiveIds())
+        {
+            auto& data = index->archiveData(archiveId);
+
+            ArchiveRecord archive{};
+            archive.id        = data.id;
+            archive.nameHash  = data.nameHash;
+            archive.crc       = data.crc;
+            archive.revision  = data.revision;
+            archive.firstFile = files.size();
+            archive.fileCount = data.files.size();
+            archive.whirlpool = data.whirlpool;
+            archives.push_back(archive);
+
+            for (auto&& file: data.files)
+                files.push_back({ static_cast<uint32_t>(file.id), static_cast<uint32_t>(file.nameHash) });
+        }
+
+        record.archiveCount = archives.size() - record.firstArchive;
+        indices.push_back(record);
+    }
+
+    MetadataHeader header{};
+    header.magic        = METADATA_MAGIC;
+    header.version      = METADATA_VERSION;
+    header.byteOrder    = METADATA_BYTE_ORDER_MARK;
+    header.indexCount   = indices.size();
+    header.archiveCount = archives.size();
+    header.fileCount    = files.size();
+
+    // Write to a temporary file first, so that a concurrent reader never maps a partially written snapshot
+    auto temporary = path + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(IndexRecord));
+        stream.write(reinterpret_cast<const char*>(archives.data()), archives.size() * sizeof(ArchiveRecord));
+        stream.write(reinterpret_cast<const char*>(files.data()), files.size() * sizeof(FileRecord));
+        if (!stream)
+            throw std::runtime_error("Unable to write metadata snapshot");
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Unable to replace metadata snapshot");
+}
+
+/**
+ * Maps a snapshot file.
+ * @param path  The path to the snapshot.
+ */
+MetadataSnapshot::MetadataSnapshot(const std::string& path): file_(path)
+{
+    if (file_.size() < sizeof(MetadataHeader))
+        throw std::runtime_error("Metadata snapshot is truncated");
+
+    // The records of each index are restored in the order they are laid out
+    adviseMapping(file_.data(), file_.size(), SEQUENTIAL);
+
+    MetadataHeader header{};
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (header.magic != METADATA_MAGIC)
+        throw std::runtime_error("Not a metadata snapshot");
+    if (header.version != METADATA_VERSION || header.byteOrder != METADATA_BYTE_ORDER_MARK)
+        throw std::runtime_error("Incompatible metadata snapshot");
+
+    // The records are laid out back to back after the header
+    uint64_t offset = sizeof(MetadataHeader);
+    indices_        = section<IndexRecord>(offset, header.indexCount);
+    offset += indices_.size_bytes();
+    archives_ = section<ArchiveRecord>(offset, header.archiveCount);
+    offset += archives_.size_bytes();
+    files_ = section<FileRecord>(offset, header.fileCount);
+}
+
+/**
+ * Restores an index from this snapshot, if its reference table hasn't changed since the snapshot was written.
+ * @param index   The index to restore.
+ * @param length  The current length of the compressed reference table.
+ * @param crc     The current checksum of the compressed reference table.
+ * @return        If the index was restored.
+ */
+bool MetadataSnapshot::restore(IndexFile& index, size_t length, int crc) const
+{
+    if (index.getId() >= indices_.size())
+        return false;
+
+    auto& record = indices_[index.getId()];
+    if (!record.present || record.length != length || record.crc != crc)
+        return false;
+
+    // Validate the record ranges before trusting them
+    if (record.firstArchive + record.archiveCount > archives_.size())
+        throw std::runtime_error("Metadata snapshot is corrupt");
+
+    // The file metadata of every archive is allocated from one arena, as when the reference table is parsed
+    size_t fileCount = 0;
+    for (size_t i = 0; i < record.archiveCount; i++)
+        fileCount += archives_[record.firstArchive + i].fileCount;
+    auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>(std::max<size_t>(fileCount, 1) * sizeof(FileData));
+
+    std::vector<ArchiveData> archives;
+    archives.reserve(record.archiveCount);
+    for (size_t i = 0; i < record.archiveCount; i++)
+    {
+        auto& source = archives_[record.firstArchive + i];
+        if (source.firstFile + source.fileCount > files_.size())
+            throw std::runtime_error("Metadata snapshot is corrupt");
+
+        auto& archive     = archives.emplace_back(ArchiveData{ .files = std::pmr::vector<FileData>(arena.get()) });
+        archive.id        = source.id;
+        archive.nameHash  = source.nameHash;
+        archive.crc       = source.crc;
+        archive.revision  = source.revision;
+        archive.fileCount = source.fileCount;
+        archive.whirlpool = source.whirlpool;
+
+        archive.files.resize(source.fileCount);
+        for (size_t j = 0; j < source.fileCount; j++)
+        {
+            auto& file                = files_[source.firstFile + j];
+            archive.files[j].id       = file.id;
+            archive.files[j].nameHash = file.nameHash;
+        }
+    }
+
+    index.load(record.protocol, record.revision, record.named, record.whirlpool, std::move(archives), std::move(arena));
+    return true;
+}
+
+/**
+ * Gets a section of the mapped file.
+ * @param offset    The offset of the section.
+ * @param count     The number of elements in the section.
+ * @return          The section.
+ */
+template<typename T>
+std::span<const T> MetadataSnapshot::section(uint64_t offset, uint64_t count) const
+{
+    if (offset % alignof(T) != 0 || offset > file_.size() || count > (file_.size() - offset) / sizeof(T))
+        throw std::runtime_error("Metadata snapshot is corrupt");
+    return { reinterpret_cast<const T*>(file_.data() + offset), count };
+}
@@ -0,0 +1,266 @@
+#include <rsfs/metrics/Metrics.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * A histogram that can be safely read by other threads while its owning thread records into it.
+     */
+    struct AtomicHistogram
+    {
+        /**
+         * The number of samples in each bucket.
+         */
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+
+        /**
+         * The total number of samples.
+         */
+        std::atomic<uint64_t> count{ 0 };
+
+        /**
+         * The sum of all samples, in nanoseconds.
+         */
+        std::atomic<uint64_t> sum{ 0 };
+    };
+
+    /**
+     * The metrics recorded by a single thread.
+     */
+    struct Shard
+    {
+        /**
+         * The counters for each index.
+         */
+        std::array<std::array<std::atomic<uint64_t>, COUNTER_COUNT>, METRICS_INDEX_COUNT> counters{};
+
+        /**
+         * The sector read latencies.
+         */
+        AtomicHistogram sectorReads;
+
+        /**
+         * The decompression latencies, for each compression type.
+         */
+        std::array<AtomicHistogram, COMPRESSION_TYPES> decompression;
+    };
+
+    /**
+     * Keeps track of the shards of every live thread, and the totals of threads that have exited.
+     */
+    struct Registry
+    {
+        /**
+         * The mutex guarding the registry. This is only taken when a thread starts or exits, or
+         * when a snapshot is taken.
+         */
+        std::mutex mutex;
+
+        /**
+         * The shards of the live threads.
+         */
+        std::vector<Shard*> shards;
+
+        /**
+         * The totals of the threads that have exited.
+         */
+        MetricsSnapshot retired;
+    };
+
+    /**
+     * Gets the registry. This is intentionally never destroyed, as threads may exit after static destruction.
+     * @return  The registry.
+     */
+    Registry& registry()
+    {
+        static auto* registry = new Registry;
+        return *registry;
+    }
+
+    /**
+     * Adds a value to an atomic that is only ever written by the current thread. This avoids the cost of an
+     * atomic read-modify-write, while still allowing other threads to read the value.
+     * @param value     The atomic value.
+     * @param amount    The amount to add.
+     */
+    void add(std::atomic<uint64_t>& value, uint64_t amount)
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * Records a sample into a histogram owned by the current thread.
+     * @param histogram The histogram.
+     * @param elapsed   The sample.
+     */
+    void record(AtomicHistogram& histogram, std::chrono::nanoseconds elapsed)
+    {
+        auto nanos = static_cast<uint64_t>(std::max<int64_t>(elapsed.count(), 0));
+        add(histogram.buckets[Histogram::bucket(nanos)], 1);
+        add(histogram.count, 1);
+        add(histogram.sum, nanos);
+    }
+
+    /**
+     * Accumulates an atomic histogram into a histogram.
+     * @param from  The histogram to read from.
+     * @param to    The histogram to add to.
+     */
+    void accumulate(const AtomicHistogram& from, Histogram& to)
+    {
+        for (auto i = 0; i < HISTOGRAM_BUCKETS; i++)
+            to.buckets[i] += from.buckets[i].load(std::memory_order_relaxed);
+        to.count += from.count.load(std::memory_order_relaxed);
+        to.sum += from.sum.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Accumulates a shard into a snapshot.
+     * @param shard     The shard to read from.
+     * @param snapshot  The snapshot to add to.
+     */
+    void accumulate(const Shard& shard, MetricsSnapshot& snapshot)
+    {
+        for (auto index = 0; index < METRICS_INDEX_COUNT; index++)
+        {
+            for (auto counter = 0; counter < COUNTER_COUNT; counter++)
+                snapshot.counters[index][counter] += shard.counters[index][counter].load(std::memory_order_relaxed);
+        }
+        accumulate(shard.sectorReads, snapshot.sectorReads);
+        for (auto type = 0; type < COMPRESSION_TYPES; type++)
+            accumulate(shard.decompression[type], snapshot.decompression[type]);
+    }
+
+    /**
+     * Registers the shard of a thread for as long as the thread is alive.
+     */
+    struct ShardHandle
+    {
+        /**
+         * The shard of this thread.
+         */
+        Shard shard;
+
+        /**
+         * Registers the shard with the registry.
+         */
+        ShardHandle()
+        {
+            auto& reg = registry();
+            std::lock_guard lock(reg.mutex);
+            reg.shards.push_back(&shard);
+        }
+
+        /**
+         * Folds the shard into the retired totals, and removes it from the registry.
+         */
+        ~ShardHandle()
+        {
+            auto& reg = registry();
+            std::lock_guard lock(reg.mutex);
+            accumulate(shard, reg.retired);
+            reg.shards.erase(std::find(reg.shards.begin(), reg.shards.end(), &shard));
+        }
+    };
+
+    /**
+     * Gets the shard of the current thread.
+     * @return  The shard.
+     */
+    Shard& local()
+    {
+        thread_local ShardHandle handle;
+        return handle.shard;
+    }
+}
+
+/**
+ * Gets the bucket that a sample falls into.
+ * @param nanos The sample, in nanoseconds.
+ * @return      The bucket index.
+ */
+size_t Histogram::bucket(uint64_t nanos)
+{
+    auto bucket = nanos == 0 ? 0 : std::bit_width(nanos) - 1;
+    return std::min<size_t>(bucket, HISTOGRAM_BUCKETS - 1);
+}
+
+/**
+ * Estimates a percentile of this histogram, using the upper bound of the bucket it falls into.
+ * @param fraction  The percentile, in the range [0, 1].
+ * @return          The estimated latency, in nanoseconds.
+ */
+uint64_t Histogram::percentile(double fraction) const
+{
+    if (count == 0)
+        return 0;
+
+    // The percentile is the smallest sample that at least this many samples are less than or equal to
+    auto target   = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count)));
+    target        = std::clamp<uint64_t>(target, 1, count);
+    uint64_t seen = 0;
+    for (auto i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen >= target)
+            return (uint64_t{ 2 } << i) - 1;
+    }
+    return (uint64_t{ 2 } << (HISTOGRAM_BUCKETS - 1)) - 1;
+}
+
+/**
+ * Increments a counter for an index.
+ * @param index     The index id.
+ * @param counter   The counter.
+ * @param amount    The amount to increment by.
+ */
+void Metrics::increment(size_t index, Counter counter, uint64_t amount)
+{
+    if (index >= METRICS_INDEX_COUNT || counter >= COUNTER_COUNT)
+        return;
+    add(local().counters[index][counter], amount);
+}
+
+/**
+ * Records the latency of a sector read.
+ * @param elapsed   The time taken to read the sector.
+ */
+void Metrics::recordSectorRead(std::chrono::nanoseconds elapsed)
+{
+    record(local().sectorReads, elapsed);
+}
+
+/**
+ * Records the latency of a decompression.
+ * @param type      The compression type.
+ * @param elapsed   The time taken to decompress the data.
+ */
+void Metrics::recordDecompression(CompressionType type, std::chrono::nanoseconds elapsed)
+{
+    if (type >= COMPRESSION_TYPES)
+        return;
+    record(local().decompression[type], elapsed);
+}
+
+/**
+ * Aggregates the metrics recorded by every thread, including threads that have since exited.
+ * @return  The aggregated metrics.
+ */
+MetricsSnapshot Metrics::snapshot()
+{
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+
+    auto snapshot = reg.retired;
+    for (auto* shard: reg.shards)
+        accumulate(*shard, snapshot);
+    return snapshot;
+}
@@ -0,0 +1,288 @@
+#include "util/BigEndian.hpp"
+#include "util/Parallel.hpp"
+
+#include <rsfs/optimise/CacheOptimiser.hpp>
+
+#include <boost/crc.hpp>
+#include <crypto++/whrlpool.h>
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <optional>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * A compression type and level to try.
+     */
+    struct Candidate
+    {
+        CompressionType type;
+        int level;
+    };
+
+    /**
+     * Collects the compression types that a set of containers already use.
+     * @param containers    The containers.
+     * @return              The types, in ascending order.
+     */
+    std::vector<CompressionType> presentTypes(const std::vector<RSBuffer>& containers)
+    {
+        std::array<bool, COMPRESSION_TYPES> present{};
+        for (auto& container: containers)
+        {
+            if (container.getSize() < CONTAINER_HEADER_LENGTH)
+                continue;
+
+            auto type = Compression::containerHeader(container.begin(), container.getSize()).type;
+            if (type < COMPRESSION_TYPES)
+                present[type] = true;
+        }
+
+        std::vector<CompressionType> types;
+        for (auto type = 0; type < COMPRESSION_TYPES; type++)
+        {
+            if (present[type])
+                types.push_back(static_cast<CompressionType>(type));
+        }
+        return types;
+    }
+
+    /**
+     * Collects the compression types and levels to try.
+     * @param types     The compression types.
+     * @param levels    The compression levels, for the types that have levels.
+     * @return          The candidates.
+     */
+    std::vector<Candidate> collectCandidates(const std::vector<CompressionType>& types, const std::vector<int>& levels)
+    {
+        std::vector<Candidate> candidates;
+        for (auto type: types)
+        {
+            // Only GZIP and LZMA have levels, as BZIP2 containers always use the same block size
+            if (type != GZIP && type != LZMA)
+            {
+                candidates.push_back({ type, DEFAULT_COMPRESSION_LEVEL });
+                continue;
+            }
+
+            for (auto level: levels)
+                candidates.push_back({ type, level });
+        }
+        return candidates;
+    }
+
+    /**
+     * Gets the length of a container, excluding its trailing revision.
+     * @param container The container.
+     * @return          The length of the header and payload.
+     */
+    size_t payloadEnd(const RSBuffer& container)
+    {
+        auto end = Compression::containerHeader(container.begin(), container.getSize()).payloadEnd();
+        return std::min(end, container.getSize());
+    }
+
+    /**
+     * Gets the revision that follows the payload of a container, if it has one.
+     * @param container The container.
+     * @return          The revision.
+     */
+    std::optional<uint16_t> containerRevision(const RSBuffer& container)
+    {
+        auto end = payloadEnd(container);
+        if (container.getSize() < end + CONTAINER_REVISION_SIZE)
+            return std::nullopt;
+        return decodeShort(container.begin() + end);
+    }
+
+    /**
+     * Calculates the checksum of a container, as stored in a reference table.
+     * @param container The container.
+     * @return          The CRC32 checksum of the container, excluding its revision.
+     */
+    int containerChecksum(const RSBuffer& container)
+    {
+        boost::crc_32_type checksum;
+        checksum.process_block(container.begin(), container.begin() + payloadEnd(container));
+        return static_cast<int>(checksum.checksum());
+    }
+
+    /**
+     * Calculates the digest of a container, as stored in a reference table.
+     * @param container The container.
+     * @return          The whirlpool digest of the container, excluding its revision.
+     */
+    std::array<char, WHIRLPOOL_SIZE> containerDigest(const RSBuffer& container)
+    {
+        std::array<char, WHIRLPOOL_SIZE> digest{ 0 };
+        CryptoPP::Whirlpool hash;
+        hash.Update(reinterpret_cast<const byte*>(container.begin()), payloadEnd(container));
+        hash.Final(reinterpret_cast<byte*>(digest.data()));
+        return digest;
+    }
+
+    /**
+     * Checks if a container decompresses to exactly the expected data.
+     * @param container The container.
+     * @param expected  The expected data.
+     * @return          If the data is identical.
+     */
+    bool identical(RSBuffer container, const RSBuffer& expected)
+    {
+        try
+        {
+            auto data = Compression::decompress(container);
+            return std::equal(data.begin(), data.end(), expected.begin(), expected.end());
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    /**
+     * Compresses data with every candidate, and keeps the smallest container that decompresses identically.
+     * @param data          The decompressed data.
+     * @param revision      The revision to append to the container, if any.
+     * @param candidates    The compression types and levels to try.
+     * @param container     The current container, which is replaced if a smaller one is found.
+     * @return              If a smaller container was found.
+     */
+    bool compressSmallest(const RSBuffer& data, std::optional<uint16_t> revision,
+                          const std::vector<Candidate>& candidates, RSBuffer& container)
+    {
+        auto found = false;
+        for (auto& candidate: candidates)
+        {
+            auto next = Compression::compress(data, candidate.type, revision, candidate.level);
+            if (next.getSize() < container.getSize() && identical(next, data))
+            {
+                container = std::move(next);
+                found     = true;
+            }
+        }
+        return found;
+    }
+}
+
+/**
+ * Optimises a cache.
+ * @param fs        The filesystem to optimise.
+ * @param out       The store to write the optimised cache to.
+ * @param options   The options to optimise the cache with.
+ * @return          The totals of the optimisation.
+ */
+OptimiseStats CacheOptimiser::write(RSFileSystem& fs, Store& out, OptimiseOptions options)
+{
+    auto requested = collectCandidates(options.types, options.levels);
+    OptimiseStats stats;
+
+    for (size_t id = 0; id < fs.indexCount(); id++)
+    {
+        auto& index = fs.getIndex(id);
+        auto ids    = index.archiveIds();
+
+        // Read every container, and decompress the ones that can be recompressed
+        std::vector<RSBuffer> containers(ids.size(), RSBuffer(0));
+        std::vector<size_t> originalSizes(ids.size());
+        std::vector<std::optional<uint16_t>> revisions(ids.size());
+        std::vector<std::optional<RSBuffer>> decompressed(ids.size());
+        parallelFor(
+            ids.size(),
+            [&](size_t i) {
+                containers[i]    = index.readArchive(ids[i]);
+                originalSizes[i] = containers[i].getSize();
+                revisions[i]     = containerRevision(containers[i]);
+
+                // Encrypted containers are copied as they are, as they would have to be encrypted again
+                if (index.encrypted(ids[i]))
+                    return;
+
+                try
+                {
+                    RSBuffer container(containers[i]);
+                    decompressed[i] = Compression::decompress(container);
+                }
+                catch (const std::exception&)
+                {
+                }
+            },
+            options.threads);
+
+        // Without requested types, only the types the index already uses are tried, so that the cache stays
+        // readable by the clients it was built for
+        auto candidates = options.types.empty() ? collectCandidates(presentTypes(containers), options.levels) : requested;
+
+        // Try every candidate for every archive in parallel, keeping the smallest container for each archive
+        std::vector<std::mutex> locks(ids.size());
+        std::vector<uint8_t> changed(ids.size());
+        parallelFor(
+            ids.size() * candidates.size(),
+            [&](size_t task) {
+                auto i          = task / candidates.size();
+                auto& candidate = candidates[task % candidates.size()];
+                if (!decompressed[i])
+                    return;
+
+                auto container = Compression::compress(*decompressed[i], candidate.type, revisions[i], candidate.level);
+                if (container.getSize() >= originalSizes[i] || !identical(container, *decompressed[i]))
+                    return;
+
+                std::lock_guard lock(locks[i]);
+                if (container.getSize() < containers[i].getSize())
+                {
+                    containers[i] = std::move(container);
+                    changed[i]    = 1;
+                }
+            },
+            options.threads);
+
+        // Write the containers, and update the metadata of the ones that changed
+        std::vector<ArchiveData> archives;
+        archives.reserve(ids.size());
+        auto indexChanged = false;
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            auto data = index.archiveData(ids[i]);
+            if (changed[i])
+            {
+                data.crc = containerChecksum(containers[i]);
+                if (index.whirlpool())
+                    data.whirlpool = containerDigest(containers[i]);
+                indexChanged = true;
+                stats.recompressed++;
+            }
+            else if (!decompressed[i])
+            {
+                stats.skipped++;
+            }
+
+            out.write(id, ids[i], containers[i]);
+            archives.push_back(std::move(data));
+            stats.archives++;
+            stats.bytesBefore += originalSizes[i];
+            stats.bytesAfter += containers[i].getSize();
+        }
+
+        // The reference table only has to be rewritten if an archive changed
+        auto table = fs.store().read(METADATA_INDEX, id);
+        if (indexChanged)
+        {
+            auto revision = index.revision() + 1;
+            auto encoded  = IndexFile::encode(index.protocol(), revision, index.named(), index.whirlpool(), archives);
+            auto tableRevision = containerRevision(table);
+
+            // The new table must be written even if it doesn't compress any smaller than the old one
+            table = Compression::compress(encoded, GZIP, tableRevision, DEFAULT_COMPRESSION_LEVEL);
+            compressSmallest(encoded, tableRevision, candidates, table);
+        }
+        out.write(METADATA_INDEX, id, table);
+    }
+
+    out.flush();
+    return stats;
+}
@@ -0,0 +1,267 @@
+#include "util/BigEndian.hpp"
+
+#include <rsfs/compression/Compression.hpp>
+#include <rsfs/jag/DataFile.hpp>
+#include <rsfs/report/CacheReporter.hpp>
+#include <rsfs/store/SectorStore.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace rsfs;
+
+/**
+ * The number of bytes kept from the start of each sector: enough for a large sector header and a container header.
+ */
+constexpr const auto SECTOR_PREFIX_LENGTH = LARGE_HEADER_SIZE + COMPRESSED_HEADER_LENGTH;
+
+/**
+ * The number of sectors read from the data file at a time.
+ */
+constexpr const auto SECTORS_PER_READ = 1024;
+
+namespace
+{
+    /**
+     * The start of a sector.
+     */
+    using SectorPrefix = std::array<char, SECTOR_PREFIX_LENGTH>;
+
+    /**
+     * Reads the start of every sector in a data file, in one sequential pass.
+     * @param path  The path to the data file.
+     * @return      The start of each sector.
+     */
+    std::vector<SectorPrefix> readSectors(const std::string& path)
+    {
+        std::ifstream stream(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!stream)
+            throw std::runtime_error("Unable to open data file");
+
+        size_t sectorCount = static_cast<size_t>(stream.tellg()) / SECTOR_SIZE;
+        stream.seekg(0, std::ios::beg);
+
+        std::vector<SectorPrefix> sectors(sectorCount);
+        std::vector<char> block(SECTORS_PER_READ * SECTOR_SIZE);
+        for (size_t first = 0; first < sectorCount; first += SECTORS_PER_READ)
+        {
+            auto count = std::min<size_t>(SECTORS_PER_READ, sectorCount - first);
+            stream.read(block.data(), static_cast<std::streamsize>(count * SECTOR_SIZE));
+            if (static_cast<size_t>(stream.gcount()) != count * SECTOR_SIZE)
+                throw std::runtime_error("Short read");
+
+            for (size_t i = 0; i < count; i++)
+                std::memcpy(sectors[first + i].data(), block.data() + i * SECTOR_SIZE, SECTOR_PREFIX_LENGTH);
+        }
+        return sectors;
+    }
+
+    /**
+     * Adds the container header of an archive to the statistics of its index.
+     * @param container The start of the container.
+     * @param length    The length of the container.
+     * @param encrypted If the container is encrypted.
+     * @param stats     The statistics of the index.
+     */
+    void addContainer(const char* container, size_t length, bool encrypted, IndexStats& stats)
+    {
+        if (length < CONTAINER_HEADER_LENGTH)
+            return;
+
+        auto header = Compression::containerHeader(container, length);
+        if (header.type >= COMPRESSION_TYPES)
+            return;
+
+        stats.compressionTypes[header.type]++;
+        if (encrypted)
+        {
+            stats.encrypted++;
+            return;
+        }
+
+        if (length < header.headerLength())
+            return;
+
+        // The decompressed length of an uncompressed container is its compressed length
+        stats.compressedBytes += header.compressedLength;
+        stats.decompressedBytes +=
+            header.type == NONE ? header.compressedLength : decodeInt(container + CONTAINER_HEADER_LENGTH);
+    }
+
+    /**
+     * Follows the sector chain of an archive, and adds it to the statistics of its index.
+     * @param index     The index id.
+     * @param archive   The archive id.
+     * @param entry     The index entry of the archive.
+     * @param sectors   The start of every sector.
+     * @param used      Which sectors belong to an archive, which the chain's sectors are added to.
+     * @param encrypted If the archive is encrypted.
+     * @param stats     The statistics of the index.
+     */
+    void walk(size_t index, size_t archive, const IndexEntry& entry, const std::vector<SectorPrefix>& sectors,
+              std::vector<uint8_t>& used, bool encrypted, IndexStats& stats)
+    {
+        auto largeSector = archive > 0xFFFF;
+        size_t headerSize = largeSector ? LARGE_HEADER_SIZE : SMALL_HEADER_SIZE;
+        size_t dataSize   = SECTOR_SIZE - headerSize;
+
+        stats.archives++;
+        stats.bytes += entry.length;
+
+        size_t sector    = entry.sector;
+        size_t remaining = entry.length;
+        for (size_t part = 0; remaining > 0; part++)
+        {
+            // Each sector must belong to this archive, and be the next part of it
+            if (sector == 0 || sector >= sectors.size())
+            {
+                stats.brokenChains++;
+                return;
+            }
+
+            auto header = DataFile::decodeHeader(sectors[sector].data(), largeSector);
+            if (header.archive != archive || header.part != static_cast<uint16_t>(part) || header.index != index)
+            {
+                stats.brokenChains++;
+                return;
+            }
+
+            if (part == 0)
+                addContainer(sectors[sector].data() + headerSize, entry.length, encrypted, stats);
+
+            used[sector] = 1;
+            stats.sectors++;
+
+            auto chunk = std::min(remaining, dataSize);
+            remaining -= chunk;
+            if (remaining == 0)
+            {
+                stats.wastedBytes += dataSize - chunk;
+                break;
+            }
+
+            if (header.nextSector != sector + 1)
+                stats.discontinuities++;
+            sector = header.nextSector;
+        }
+    }
+
+    /**
+     * Writes the statistics of an index as the members of a JSON object.
+     * @param out   The stream to write to.
+     * @param stats The statistics.
+     */
+    void writeStats(std::ostream& out, const IndexStats& stats)
+    {
+        out << "\"archives\":" << stats.archives << ",\"bytes\":" << stats.bytes << ",\"sectors\":" << stats.sectors
+            << ",\"wastedBytes\":" << stats.wastedBytes << ",\"sectorUtilisation\":" << stats.sectorUtilisation()
+            << ",\"discontinuities\":" << stats.discontinuities
+            << ",\"averageDiscontinuity\":" << stats.averageDiscontinuity()
+            << ",\"brokenChains\":" << stats.brokenChains << ",\"encrypted\":" << stats.encrypted
+            << ",\"compressedBytes\":" << stats.compressedBytes << ",\"decompressedBytes\":" << stats.decompressedBytes
+            << ",\"compressionRatio\":" << stats.compressionRatio() << ",\"compressionTypes\":{";
+        for (auto type = 0; type < COMPRESSION_TYPES; type++)
+        {
+            auto name = Compression::typeName(static_cast<CompressionType>(type));
+            out << (type > 0 ? "," : "") << '"' << name << "\":" << stats.compressionTypes[type];
+        }
+        out << '}';
+    }
+}
+
+/**
+ * Adds the statistics of another index to these.
+ * @param other The statistics to add.
+ */
+void IndexStats::add(const IndexStats& other)
+{
+    archives += other.archives;
+    bytes += other.bytes;
+    sectors += other.sectors;
+    wastedBytes += other.wastedBytes;
+    discontinuities += other.discontinuities;
+    brokenChains += other.brokenChains;
+    encrypted += other.encrypted;
+    compressedBytes += other.compressedBytes;
+    decompressedBytes += other.decompressedBytes;
+    for (auto type = 0; type < COMPRESSION_TYPES; type++)
+        compressionTypes[type] += other.compressionTypes[type];
+}
+
+/**
+ * Analyses the layout of a cache.
+ * @param fs    The filesystem, which must be in the sector layout.
+ * @return      The report.
+ */
+CacheReport CacheReporter::analyse(RSFileSystem& fs)
+{
+    auto* store = dynamic_cast<SectorStore*>(&fs.store());
+    if (!store)
+        throw std::runtime_error("Layout reports require a cache in the sector layout");
+
+    auto sectors = readSectors(store->dataPath());
+    std::vector<uint8_t> used(sectors.size());
+
+    std::vector<size_t> indices;
+    for (size_t id = 0; id < fs.indexCount(); id++)
+        indices.push_back(id);
+    indices.push_back(METADATA_INDEX);
+
+    CacheReport report;
+    for (auto id: indices)
+    {
+        auto& stats = report.indices.emplace_back(IndexStats{ .index = id });
+        auto entries = store->entries(id);
+        for (size_t archive = 0; archive < entries.size(); archive++)
+        {
+            auto& entry = entries[archive];
+            if (entry.length == 0 || entry.sector == 0)
+                continue;
+
+            // Archives that are missing from the reference table can't have a key
+            auto encrypted = false;
+            if (id != METADATA_INDEX)
+            {
+                try
+                {
+                    encrypted = fs.getIndex(id).encrypted(archive);
+                }
+                catch (const std::out_of_range&)
+                {
+                }
+            }
+            walk(id, archive, entry, sectors, used, encrypted, stats);
+        }
+        report.total.add(stats);
+    }
+
+    // The first sector is never used
+    report.dataSectors   = sectors.empty() ? 0 : sectors.size() - 1;
+    report.unusedSectors = report.dataSectors - std::count(used.begin(), used.end(), 1);
+    return report;
+}
+
+/**
+ * Formats a report as JSON.
+ * @param report    The report.
+ * @return          The JSON document.
+ */
+std::string CacheReporter::toJson(const CacheReport& report)
+{
+    std::ostringstream out;
+    out << "{\"dataSectors\":" << report.dataSectors << ",\"unusedSectors\":" << report.unusedSectors
+        << ",\"total\":{";
+    writeStats(out, report.total);
+    out << "},\"indices\":[";
+    for (size_t i = 0; i < report.indices.size(); i++)
+    {
+        out << (i > 0 ? "," : "") << "{\"index\":" << report.indices[i].index << ',';
+        writeStats(out, report.indices[i]);
+        out << '}';
+    }
+    out << "]}";
+    return out.str();
+}
@@ -0,0 +1,91 @@
+#include "util/BigEndian.hpp"
+#include "util/Parallel.hpp"
+
+#include <rsfs/compression/Compression.hpp>
+#include <rsfs/crypto/Xtea.hpp>
+#include <rsfs/scan/ArchiveScanner.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace rsfs;
+
+/**
+ * The length of the container prefix that is read for each archive. The decompressed length follows the unencrypted
+ * header, so this covers the first XTEA block of an encrypted payload, which is enough to decipher it.
+ */
+constexpr const auto PREFIX_LENGTH = CONTAINER_HEADER_LENGTH + XTEA_BLOCK_SIZE;
+
+/**
+ * Scans a cache.
+ * @param fs        The filesystem to scan.
+ * @param options   The options to scan the cache with.
+ * @return          The header of every archive, in index and then archive order.
+ */
+std::vector<ArchiveHeader> ArchiveScanner::scan(RSFileSystem& fs, ScanOptions options)
+{
+    auto indices = options.indices;
+    if (indices.empty())
+    {
+        for (size_t id = 0; id < fs.indexCount(); id++)
+            indices.push_back(id);
+    }
+
+    // List every archive up front, so that the reads are spread across the workers regardless of index sizes
+    std::vector<ArchiveHeader> headers;
+    for (auto id: indices)
+    {
+        for (auto archive: fs.getIndex(id).archiveIds())
+            headers.push_back({ .archive = static_cast<uint32_t>(archive), .index = static_cast<uint8_t>(id) });
+    }
+
+    std::vector<uint8_t> failed(headers.size());
+    parallelFor(
+        headers.size(),
+        [&](size_t i) {
+            auto& header = headers[i];
+            auto& index  = fs.getIndex(header.index);
+            try
+            {
+                auto container            = fs.store().readPrefix(header.index, header.archive, PREFIX_LENGTH);
+                auto parsed               = Compression::containerHeader(container.begin(), container.getSize());
+                header.type               = parsed.type;
+                header.compressedLength   = parsed.compressedLength;
+                header.decompressedLength = parsed.compressedLength;
+                if (header.type >= COMPRESSION_TYPES)
+                    throw std::runtime_error("Unknown compression type");
+
+                if (header.type != NONE)
+                {
+                    // XTEA enciphers each block on its own, so only the block holding the decompressed length has
+                    // to be deciphered. Payloads shorter than a block aren't enciphered at all.
+                    if (auto* key = index.key(header.archive))
+                    {
+                        auto length = std::min(parsed.encryptedLength(), container.getSize() - CONTAINER_HEADER_LENGTH);
+                        Xtea::decipher(container.data() + CONTAINER_HEADER_LENGTH, length, *key);
+                    }
+
+                    if (container.getSize() < COMPRESSED_HEADER_LENGTH)
+                        throw std::runtime_error("Container is truncated");
+                    header.decompressedLength = decodeInt(container.begin() + CONTAINER_HEADER_LENGTH);
+                }
+            }
+            catch (const std::exception&)
+            {
+                if (!options.skipErrors)
+                    throw;
+                failed[i] = 1;
+            }
+        },
+        options.threads);
+
+    // Leave out the archives that couldn't be read
+    size_t kept = 0;
+    for (size_t i = 0; i < headers.size(); i++)
+    {
+        if (!failed[i])
+            headers[kept++] = headers[i];
+    }
+    headers.resize(kept);
+    return headers;
+}
@@ -0,0 +1,165 @@
+#include "util/Parallel.hpp"
+
+#include <rsfs/metrics/Metrics.hpp>
+#include <rsfs/store/ArenaStore.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace rsfs;
+
+/**
+ * Reads every container from another store into an arena.
+ * @param source    The store to read from.
+ * @param threads   The number of threads to read with, or 0 to use the number of hardware threads.
+ * @return          The arena store.
+ */
+std::unique_ptr<ArenaStore> ArenaStore::load(Store& source, size_t threads)
+{
+    auto store         = std::make_unique<ArenaStore>();
+    store->indexCount_ = source.indexCount();
+
+    // Collect every container, including the reference tables
+    struct Location
+    {
+        size_t index;
+        size_t archive;
+    };
+    std::vector<Location> locations;
+    auto collect = [&](size_t index) {
+        auto ids = source.archiveIds(index);
+        if (!ids.empty())
+            store->extents_.at(index).resize(ids.back() + 1);
+        for (auto id: ids)
+            locations.push_back({ index, id });
+    };
+    collect(METADATA_INDEX);
+    for (size_t index = 0; index < store->indexCount_ && index < METADATA_INDEX; index++)
+        collect(index);
+
+    // Lay the containers out in the order they were collected, so that each index is contiguous
+    parallelFor(
+        locations.size(),
+        [&](size_t i) {
+            auto [index, archive] = locations[i];
+            store->extents_[index][archive].length = source.length(index, archive);
+        },
+        threads);
+
+    for (auto [index, archive]: locations)
+    {
+        auto& extent   = store->extents_[index][archive];
+        extent.offset  = store->size_;
+        extent.present = true;
+        store->size_ += extent.length;
+    }
+    store->arena_ = std::make_unique_for_overwrite<char[]>(store->size_);
+
+    // Resolve each container once, and copy it into its place in the arena
+    parallelFor(
+        locations.size(),
+        [&](size_t i) {
+            auto [index, archive] = locations[i];
+            auto& extent          = store->extents_[index][archive];
+            auto data             = source.read(index, archive);
+            if (data.getSize() != extent.length)
+                throw std::runtime_error("Container length changed while loading the arena");
+            std::memcpy(store->arena_.get() + extent.offset, data.begin(), extent.length);
+        },
+        threads);
+    return store;
+}
+
+/**
+ * Copies the compressed container of an archive out of the arena.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The compressed container.
+ */
+RSBuffer ArenaStore::read(size_t index, size_t archive)
+{
+    auto data = container(index, archive);
+    Metrics::increment(index, ARCHIVES_READ);
+    Metrics::increment(index, BYTES_READ, data.size());
+    return RSBuffer(data.data(), data.size());
+}
+
+/**
+ * Gets the length of the compressed container of an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The length, in bytes.
+ */
+size_t ArenaStore::length(size_t index, size_t archive)
+{
+    return container(index, archive).size();
+}
+
+/**
+ * Copies the start of the compressed container of an archive out of the arena.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param length    The maximum number of bytes to read.
+ * @return          The start of the container.
+ */
+RSBuffer ArenaStore::readPrefix(size_t index, size_t archive, size_t length)
+{
+    auto data = container(index, archive);
+    return RSBuffer(data.data(), std::min(length, data.size()));
+}
+
+/**
+ * Gets the compressed container of an archive in the arena, without copying it.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The container.
+ */
+std::optional<std::span<const char>> ArenaStore::view(size_t index, size_t archive)
+{
+    auto data = container(index, archive);
+    Metrics::increment(index, ARCHIVES_READ);
+    Metrics::increment(index, BYTES_READ, data.size());
+    return data;
+}
+
+/**
+ * Arena stores are read-only.
+ */
+void ArenaStore::write(size_t /* index */, size_t /* archive */, const RSBuffer& /* container */)
+{
+    throw std::runtime_error("Arena stores are read-only");
+}
+
+/**
+ * Gets the ids of the archives that are held for an index.
+ * @param index The index id.
+ * @return      The sorted archive ids.
+ */
+std::vector<size_t> ArenaStore::archiveIds(size_t index)
+{
+    std::vector<size_t> ids;
+    auto& extents = extents_.at(index);
+    for (size_t id = 0; id < extents.size(); id++)
+    {
+        if (extents[id].present)
+            ids.push_back(id);
+    }
+    return ids;
+}
+
+/**
+ * Gets the compressed container of an archive, without copying it.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The container.
+ */
+std::span<const char> ArenaStore::container(size_t index, size_t archive) const
+{
+    auto& extents = extents_.at(index);
+    if (archive >= extents.size() || !extents[archive].present)
+        throw std::runtime_error("Archive not found");
+
+    auto& extent = extents[archive];
+    return { arena_.get() + extent.offset, extent.length };
+}
@@ -0,0 +1,160 @@
+#include <rsfs/metrics/Metrics.hpp>
+#include <rsfs/store/FlatFileStore.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+using namespace rsfs;
+
+/**
+ * The extension of an archive file.
+ */
+constexpr auto ARCHIVE_EXTENSION = ".dat";
+
+/**
+ * Opens a flat store in a directory.
+ * @param path  The path to the directory.
+ */
+FlatFileStore::FlatFileStore(std::string path): path_(std::move(path))
+{
+}
+
+/**
+ * Reads the compressed container of an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The compressed container.
+ */
+RSBuffer FlatFileStore::read(size_t index, size_t archive)
+{
+    std::ifstream stream(archivePath(index, archive), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!stream)
+        throw std::runtime_error("Archive not found");
+
+    size_t length = stream.tellg();
+    stream.seekg(0, std::ios::beg);
+
+    RSBuffer buffer(0);
+    buffer.resize(length);
+    stream.read(buffer.data(), static_cast<std::streamsize>(length));
+    if (static_cast<size_t>(stream.gcount()) != length)
+        throw std::runtime_error("Short read");
+
+    Metrics::increment(index, ARCHIVES_READ);
+    Metrics::increment(index, BYTES_READ, length);
+    return buffer;
+}
+
+/**
+ * Gets the length of the compressed container of an archive from the size of its file.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The length, in bytes.
+ */
+size_t FlatFileStore::length(size_t index, size_t archive)
+{
+    std::error_code error;
+    auto size = std::filesystem::file_size(archivePath(index, archive), error);
+    if (error)
+        throw std::runtime_error("Archive not found");
+    return size;
+}
+
+/**
+ * Reads the start of the compressed container of an archive, without reading the rest of its file.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param length    The maximum number of bytes to read.
+ * @return          The start of the container.
+ */
+RSBuffer FlatFileStore::readPrefix(size_t index, size_t archive, size_t length)
+{
+    std::ifstream stream(archivePath(index, archive), std::ios::in | std::ios::binary);
+    if (!stream)
+        throw std::runtime_error("Archive not found");
+
+    RSBuffer buffer(0);
+    buffer.resize(length);
+    stream.read(buffer.data(), static_cast<std::streamsize>(length));
+    buffer.resize(stream.gcount());
+
+    Metrics::increment(index, BYTES_READ, buffer.getSize());
+    return buffer;
+}
+
+/**
+ * Writes the compressed container of an archive, replacing the file atomically.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param container The compressed container.
+ */
+void FlatFileStore::write(size_t index, size_t archive, const RSBuffer& container)
+{
+    auto path      = archivePath(index, archive);
+    auto temporary = path;
+    temporary += ".tmp";
+    std::filesystem::create_directories(path.parent_path());
+
+    {
+        std::ofstream out(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(container.begin(), static_cast<std::streamsize>(container.getSize()));
+        if (!out)
+            throw std::runtime_error("Unable to write archive file");
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Unable to replace archive file");
+}
+
+/**
+ * Gets the ids of the archives that have a file in an index's directory.
+ * @param index The index id.
+ * @return      The sorted archive ids.
+ */
+std::vector<size_t> FlatFileStore::archiveIds(size_t index)
+{
+    std::vector<size_t> ids;
+
+    auto directory = path_ / std::to_string(index);
+    if (!std::filesystem::is_directory(directory))
+        return ids;
+
+    for (auto& file: std::filesystem::directory_iterator(directory))
+    {
+        auto& path = file.path();
+        if (!file.is_regular_file() || path.extension() != ARCHIVE_EXTENSION)
+            continue;
+
+        // Ignore files that aren't named after an archive id
+        auto name = path.stem().string();
+        if (name.empty() || !std::all_of(name.begin(), name.end(), [](char c) { return c >= '0' && c <= '9'; }))
+            continue;
+        ids.push_back(std::stoul(name));
+    }
+
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/**
+ * Gets the number of indices, which is one more than the highest reference table id.
+ * @return  The number of indices.
+ */
+size_t FlatFileStore::indexCount()
+{
+    auto tables = archiveIds(METADATA_INDEX);
+    return tables.empty() ? 0 : tables.back() + 1;
+}
+
+/**
+ * Gets the path to the file of an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The archive path.
+ */
+std::filesystem::path FlatFileStore::archivePath(size_t index, size_t archive) const
+{
+    return path_ / std::to_string(index) / (std::to_string(archive) + ARCHIVE_EXTENSION);
+}
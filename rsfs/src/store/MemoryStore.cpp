@@ -0,0 +1,100 @@
+#include <rsfs/metrics/Metrics.hpp>
+#include <rsfs/store/MemoryStore.hpp>
+
+#include <mutex>
+#include <stdexcept>
+
+using namespace rsfs;
+
+/**
+ * Copies every container from another store into memory.
+ * @param source    The store to copy.
+ * @return          The in-memory copy.
+ */
+std::unique_ptr<MemoryStore> MemoryStore::copy(Store& source)
+{
+    auto store = std::make_unique<MemoryStore>();
+
+    auto copyIndex = [&](size_t index) {
+        for (auto archive: source.archiveIds(index))
+            store->write(index, archive, source.read(index, archive));
+    };
+
+    copyIndex(METADATA_INDEX);
+    for (size_t index = 0; index < source.indexCount(); index++)
+        copyIndex(index);
+    return store;
+}
+
+/**
+ * Reads the compressed container of an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The compressed container.
+ */
+RSBuffer MemoryStore::read(size_t index, size_t archive)
+{
+    std::shared_lock lock(mutex_);
+    auto it = containers_.find({ index, archive });
+    if (it == containers_.end())
+        throw std::runtime_error("Archive not found");
+
+    Metrics::increment(index, ARCHIVES_READ);
+    Metrics::increment(index, BYTES_READ, it->second.getSize());
+    return it->second;
+}
+
+/**
+ * Gets the length of the compressed container of an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The length, in bytes.
+ */
+size_t MemoryStore::length(size_t index, size_t archive)
+{
+    std::shared_lock lock(mutex_);
+    auto it = containers_.find({ index, archive });
+    if (it == containers_.end())
+        throw std::runtime_error("Archive not found");
+    return it->second.getSize();
+}
+
+/**
+ * Writes the compressed container of an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param container The compressed container.
+ */
+void MemoryStore::write(size_t index, size_t archive, const RSBuffer& container)
+{
+    RSBuffer copy(container);
+    copy.resetReaderIndex();
+
+    std::unique_lock lock(mutex_);
+    containers_.insert_or_assign({ index, archive }, std::move(copy));
+}
+
+/**
+ * Gets the ids of the archives that are held for an index.
+ * @param index The index id.
+ * @return      The sorted archive ids.
+ */
+std::vector<size_t> MemoryStore::archiveIds(size_t index)
+{
+    std::shared_lock lock(mutex_);
+
+    std::vector<size_t> ids;
+    for (auto it = containers_.lower_bound({ index, 0 }); it != containers_.end() && it->first.first == index; ++it)
+        ids.push_back(it->first.second);
+    return ids;
+}
+
+/**
+ * Gets the number of indices, which is one more than the highest reference table id.
+ * @return  The number of indices.
+ */
+size_t MemoryStore::indexCount()
+{
+    auto tables = archiveIds(METADATA_INDEX);
+    return tables.empty() ? 0 : tables.back() + 1;
+}
@@ -0,0 +1,409 @@
+#include <rsfs/store/SectorStore.hpp>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+using namespace rsfs;
+
+/**
+ * The name of the data file.
+ */
+constexpr auto DATA_NAME = "main_file_cache.dat2";
+
+/**
+ * The name of an index file, without the trailing id.
+ */
+constexpr auto INDEX_NAME = "main_file_cache.idx";
+
+/**
+ * The size of an entry in an index file.
+ */
+constexpr auto ENTRY_SIZE = 6;
+
+/**
+ * The largest value that fits in an index entry field.
+ */
+constexpr auto MAX_ENTRY_VALUE = 0xFFFFFFu;
+
+/**
+ * The flags to open a file with.
+ */
+constexpr auto FILE_FLAGS = std::ios::in | std::ios::binary | std::ios::ate;
+
+/**
+ * Opens the data files in a directory.
+ * @param path  The path to the directory, including a trailing separator.
+ * @param hints How the data file will be read.
+ */
+SectorStore::SectorStore(std::string path, IoHints hints): path_(std::move(path))
+{
+    dataFile_ = std::make_unique<DataFile>(dataPath(), hints);
+}
+
+/**
+ * Creates an empty store in a directory, or opens the store if its data files already exist.
+ * @param path  The path to the directory, including a trailing separator.
+ * @return      The store.
+ */
+std::unique_ptr<SectorStore> SectorStore::create(const std::string& path)
+{
+    if (!path.empty())
+        std::filesystem::create_directories(path);
+
+    // The first sector is never used, as a sector of 0 marks the end of a chain
+    auto dataPath = path + DATA_NAME;
+    if (!std::filesystem::exists(dataPath))
+    {
+        std::array<char, SECTOR_SIZE> empty{};
+        std::ofstream(dataPath, std::ios::out | std::ios::binary).write(empty.data(), empty.size());
+    }
+
+    auto metadataPath = path + INDEX_NAME + std::to_string(METADATA_INDEX);
+    if (!std::filesystem::exists(metadataPath))
+        std::ofstream(metadataPath, std::ios::out | std::ios::binary);
+
+    return std::make_unique<SectorStore>(path);
+}
+
+/**
+ * Flushes the writes that haven't been flushed yet.
+ */
+SectorStore::~SectorStore()
+{
+    try
+    {
+        flush();
+    }
+    catch (const std::exception& e)
+    {
+        LOG(ERROR) << "Unable to flush writes to " << path_ << ": " << e.what();
+    }
+}
+
+/**
+ * Reads the compressed container of an archive.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The compressed container.
+ */
+RSBuffer SectorStore::read(size_t index, size_t archive)
+{
+    auto archiveEntry = entry(index, archive);
+    return dataFile_->read(index, archive, archiveEntry.sector, archiveEntry.length);
+}
+
+/**
+ * Gets the length of the compressed container of an archive from its index file.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The length, in bytes.
+ */
+size_t SectorStore::length(size_t index, size_t archive)
+{
+    return entry(index, archive).length;
+}
+
+/**
+ * Reads the start of the compressed container of an archive, from only the sectors that it spans.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param length    The maximum number of bytes to read.
+ * @return          The start of the container.
+ */
+RSBuffer SectorStore::readPrefix(size_t index, size_t archive, size_t length)
+{
+    auto archiveEntry = entry(index, archive);
+    return dataFile_->read(index, archive, archiveEntry.sector, std::min<size_t>(length, archiveEntry.length));
+}
+
+/**
+ * Writes the compressed container of an archive, appending it to the data file. Its index entry is written when the
+ * writes are flushed.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @param container The compressed container.
+ */
+void SectorStore::write(size_t index, size_t archive, const RSBuffer& container)
+{
+    std::lock_guard lock(writeMutex_);
+
+    // The data file stays open for writing until the writes are flushed
+    if (!dataWriter_.is_open())
+    {
+        dataWriter_.clear();
+        dataWriter_.open(dataPath(), std::ios::in | std::ios::out | std::ios::binary);
+        if (!dataWriter_)
+            throw std::runtime_error("Unable to open data file for writing");
+
+        dataWriter_.seekp(0, std::ios::end);
+        dataEnd_ = dataWriter_.tellp();
+    }
+
+    // Start a new chain of sectors after the last sector in the file
+    size_t first = std::max<size_t>((dataEnd_ + SECTOR_SIZE - 1) / SECTOR_SIZE, 1);
+
+    auto length      = container.getSize();
+    auto largeSector = archive > 0xFFFF;
+    auto headerSize  = largeSector ? LARGE_HEADER_SIZE : SMALL_HEADER_SIZE;
+    auto dataSize    = SECTOR_SIZE - headerSize;
+    auto sectorCount = std::max<size_t>((length + dataSize - 1) / dataSize, 1);
+    if (length > MAX_ENTRY_VALUE || first + sectorCount > MAX_ENTRY_VALUE)
+        throw std::runtime_error("Container doesn't fit in the sector layout");
+
+    // Build the whole chain, so that it is written at once
+    std::vector<char> chain(sectorCount * SECTOR_SIZE);
+    for (size_t part = 0; part < sectorCount; part++)
+    {
+        SectorHeader header;
+        header.archive    = archive;
+        header.part       = part;
+        header.nextSector = part + 1 < sectorCount ? first + part + 1 : 0;
+        header.index      = index;
+
+        auto* sector = chain.data() + part * SECTOR_SIZE;
+        auto offset  = part * dataSize;
+        DataFile::encodeHeader(header, sector, largeSector);
+        std::memcpy(sector + headerSize, container.begin() + offset, std::min<size_t>(dataSize, length - offset));
+    }
+
+    // Chains written one after another are contiguous, so the stream only seeks when the file ends mid-sector
+    if (first * SECTOR_SIZE != dataEnd_)
+        dataWriter_.seekp(first * SECTOR_SIZE, std::ios::beg);
+    dataWriter_.write(chain.data(), static_cast<std::streamsize>(chain.size()));
+    if (!dataWriter_)
+        throw std::runtime_error("Unable to write to data file");
+
+    dataEnd_ = (first + sectorCount) * SECTOR_SIZE;
+    pendingEntries_[index].push_back({ archive, { static_cast<uint32_t>(length), static_cast<uint32_t>(first) } });
+}
+
+/**
+ * Writes the index entries of the containers written since the last flush, and reopens the files so that readers
+ * see them.
+ */
+void SectorStore::flush()
+{
+    std::lock_guard lock(writeMutex_);
+    if (!dataWriter_.is_open())
+        return;
+
+    // The chains must be in the data file before any entry points at them
+    dataWriter_.close();
+    if (!dataWriter_)
+    {
+        pendingEntries_.clear();
+        throw std::runtime_error("Unable to write to data file");
+    }
+
+    auto pending = std::move(pendingEntries_);
+    pendingEntries_.clear();
+    for (auto& [index, entries]: pending)
+    {
+        // Create the index file if this is a new index
+        auto path = indexPath(index);
+        if (!std::filesystem::exists(path))
+            std::ofstream(path, std::ios::out | std::ios::binary);
+
+        std::fstream indexFile(path, std::ios::in | std::ios::out | std::ios::binary);
+        for (auto& [archive, entry]: entries)
+        {
+            RSBuffer buf(ENTRY_SIZE);
+            buf.writeByte(entry.length >> 16);
+            buf.writeByte(entry.length >> 8);
+            buf.writeByte(entry.length);
+            buf.writeByte(entry.sector >> 16);
+            buf.writeByte(entry.sector >> 8);
+            buf.writeByte(entry.sector);
+
+            indexFile.seekp(archive * ENTRY_SIZE, std::ios::beg);
+            indexFile.write(buf.begin(), ENTRY_SIZE);
+        }
+
+        indexFile.close();
+        if (!indexFile)
+            throw std::runtime_error("Unable to write to index file");
+    }
+
+    // Pick up the new length of the data file, and the new entries
+    reopen();
+}
+
+/**
+ * Gets the ids of the archives that have an entry in an index file.
+ * @param index The index id.
+ * @return      The sorted archive ids.
+ */
+std::vector<size_t> SectorStore::archiveIds(size_t index)
+{
+    auto indexEntries = entries(index);
+
+    std::vector<size_t> ids;
+    for (size_t id = 0; id < indexEntries.size(); id++)
+    {
+        if (indexEntries[id].length > 0 && indexEntries[id].sector > 0)
+            ids.push_back(id);
+    }
+    return ids;
+}
+
+/**
+ * Gets the number of indices, which is the number of entries in the metadata index file.
+ * @return  The number of indices.
+ */
+size_t SectorStore::indexCount()
+{
+    auto& stream = streams_.at(METADATA_INDEX);
+    std::lock_guard lock(stream.mutex);
+    openStream(METADATA_INDEX, stream);
+    return stream.entryCount;
+}
+
+/**
+ * Reopens the data file, and closes the index files so that they are reopened the next time they are read from.
+ */
+void SectorStore::reopen()
+{
+    // Readers with their own view of the data file reopen it too, before they can read any of the new entries
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    dataFile_->reopen();
+    for (auto& stream: streams_)
+    {
+        std::lock_guard lock(stream.mutex);
+        stream.stream.close();
+    }
+}
+
+/**
+ * Asks the operating system to read the sectors of every archive in an index into the page cache in the background.
+ * @param index The index id.
+ */
+void SectorStore::preload(size_t index)
+{
+    auto indexEntries = entries(index);
+
+    // The sectors that each archive spans, if its chain is contiguous
+    std::vector<std::pair<size_t, size_t>> runs;
+    for (size_t archive = 0; archive < indexEntries.size(); archive++)
+    {
+        auto& entry = indexEntries[archive];
+        if (entry.length == 0 || entry.sector == 0)
+            continue;
+
+        auto dataSize = SECTOR_SIZE - (archive > 0xFFFF ? LARGE_HEADER_SIZE : SMALL_HEADER_SIZE);
+        runs.emplace_back(entry.sector, entry.sector + (entry.length + dataSize - 1) / dataSize);
+    }
+
+    // Merge the runs of neighbouring archives, so that there is one request for each run of the data file
+    std::sort(runs.begin(), runs.end());
+    for (size_t i = 0; i < runs.size();)
+    {
+        auto [start, end] = runs[i];
+        for (i++; i < runs.size() && runs[i].first <= end; i++)
+            end = std::max(end, runs[i].second);
+        dataFile_->prefetch(start, end - start);
+    }
+}
+
+/**
+ * Reads the entry of an archive from its index file.
+ * @param index     The index id.
+ * @param archive   The archive id.
+ * @return          The entry.
+ */
+IndexEntry SectorStore::entry(size_t index, size_t archive)
+{
+    auto& stream = streams_.at(index);
+    std::lock_guard lock(stream.mutex);
+    openStream(index, stream);
+
+    stream.stream.seekg(archive * ENTRY_SIZE, std::ios::beg);
+    char tmp[ENTRY_SIZE];
+
+    auto bytesRead = stream.stream.readsome(tmp, ENTRY_SIZE);
+    if (bytesRead != ENTRY_SIZE)
+    {
+        throw std::runtime_error("Short read");
+    }
+
+    RSBuffer buf(tmp, ENTRY_SIZE);
+    auto length = buf.readTriByte();
+    auto sector = buf.readTriByte();
+
+    return { length, sector };
+}
+
+/**
+ * Reads every entry of an index file at once.
+ * @param index The index id.
+ * @return      The entries, by archive id.
+ */
+std::vector<IndexEntry> SectorStore::entries(size_t index)
+{
+    auto& stream = streams_.at(index);
+    std::lock_guard lock(stream.mutex);
+    openStream(index, stream);
+
+    // Read every entry at once, rather than seeking to each of them
+    std::vector<char> data(stream.entryCount * ENTRY_SIZE);
+    stream.stream.seekg(0, std::ios::beg);
+    stream.stream.read(data.data(), static_cast<std::streamsize>(data.size()));
+    if (static_cast<size_t>(stream.stream.gcount()) != data.size())
+        throw std::runtime_error("Short read");
+
+    std::vector<IndexEntry> indexEntries(stream.entryCount);
+    RSBuffer buf(data.data(), data.size());
+    for (auto& entry: indexEntries)
+    {
+        entry.length = buf.readTriByte();
+        entry.sector = buf.readTriByte();
+    }
+    return indexEntries;
+}
+
+/**
+ * Opens an index file, if it hasn't been opened yet.
+ * @param index     The index id.
+ * @param stream    The stream of the index.
+ */
+void SectorStore::openStream(size_t index, IndexStream& stream) const
+{
+    if (stream.stream.is_open())
+        return;
+
+    stream.stream.clear();
+    stream.stream.open(indexPath(index), FILE_FLAGS);
+    if (!stream.stream)
+        throw std::runtime_error("Unable to open index file");
+
+    // Calculate the number of entries
+    stream.entryCount = stream.stream.tellg() / ENTRY_SIZE;
+    stream.stream.seekg(std::ios::beg);
+}
+
+/**
+ * Gets the path to the data file.
+ * @return  The data file path.
+ */
+std::string SectorStore::dataPath() const
+{
+    std::stringstream stream;
+    stream << path_ << DATA_NAME;
+    return stream.str();
+}
+
+/**
+ * Gets the path to an index file.
+ * @param id    The id of the index.
+ * @return      The index file path.
+ */
+std::string SectorStore::indexPath(size_t id) const
+{
+    std::stringstream stream;
+    stream << path_ << INDEX_NAME << id;
+    return stream.str();
+}
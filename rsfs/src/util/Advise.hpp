@@ -0,0 +1,66 @@
+#pragma once
+
+#include <rsfs/jag/IoHints.hpp>
+
+#include <cstddef>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+namespace rsfs
+{
+    /**
+     * Tells the operating system how an open file will be read. Sequential access doubles the kernel's readahead,
+     * and random access turns it off.
+     * @param fd        The file descriptor.
+     * @param pattern   How the file will be read.
+     */
+    inline void adviseFile(int fd, AccessPattern pattern)
+    {
+#ifdef __linux__
+        auto advice = POSIX_FADV_NORMAL;
+        if (pattern == SEQUENTIAL)
+            advice = POSIX_FADV_SEQUENTIAL;
+        else if (pattern == RANDOM)
+            advice = POSIX_FADV_RANDOM;
+        ::posix_fadvise(fd, 0, 0, advice);
+#endif
+    }
+
+    /**
+     * Asks the operating system to read part of an open file into the page cache in the background.
+     * @param fd        The file descriptor.
+     * @param offset    The offset of the first byte.
+     * @param length    The number of bytes.
+     */
+    inline void requestRange(int fd, size_t offset, size_t length)
+    {
+#ifdef __linux__
+        ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+#endif
+    }
+
+    /**
+     * Tells the operating system how a mapped file will be read, and asks it to start reading the file in the
+     * background, so that the first accesses to the mapping don't each fault on a page that hasn't been read yet.
+     * @param data      The start of the mapping, which must be page aligned.
+     * @param length    The length of the mapping.
+     * @param pattern   How the mapping will be read.
+     */
+    inline void adviseMapping(const char* data, size_t length, AccessPattern pattern)
+    {
+#ifdef __linux__
+        if (!data || length == 0)
+            return;
+
+        auto* address = const_cast<char*>(data);
+        if (pattern == SEQUENTIAL)
+            ::madvise(address, length, MADV_SEQUENTIAL);
+        else if (pattern == RANDOM)
+            ::madvise(address, length, MADV_RANDOM);
+        ::madvise(address, length, MADV_WILLNEED);
+#endif
+    }
+}
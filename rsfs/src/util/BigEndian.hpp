@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace rsfs
+{
+#if defined(__SSE2__)
+    /**
+     * Reverses the byte order of each two-byte lane in a vector.
+     * @param value The vector.
+     * @return      The byte swapped vector.
+     */
+    inline __m128i byteSwapShorts(__m128i value)
+    {
+        return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+    }
+
+    /**
+     * Calculates the running total of the four lanes in a vector.
+     * @param value The vector.
+     * @return      The running totals.
+     */
+    inline __m128i prefixSum(__m128i value)
+    {
+        value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+        return _mm_add_epi32(value, _mm_slli_si128(value, 8));
+    }
+#endif
+
+    /**
+     * Decodes a big-endian four-byte integer.
+     * @param source    The encoded integer.
+     * @return          The integer.
+     */
+    inline uint32_t decodeInt(const char* source)
+    {
+        auto* bytes = reinterpret_cast<const uint8_t*>(source);
+        return (bytes[0] << 24u) | (bytes[1] << 16u) | (bytes[2] << 8u) | bytes[3];
+    }
+
+    /**
+     * Decodes a big-endian two-byte integer.
+     * @param source    The encoded integer.
+     * @return          The integer.
+     */
+    inline uint16_t decodeShort(const char* source)
+    {
+        auto* bytes = reinterpret_cast<const uint8_t*>(source);
+        return static_cast<uint16_t>((bytes[0] << 8u) | bytes[1]);
+    }
+
+    /**
+     * Encodes a big-endian four-byte integer.
+     * @param out   The destination.
+     * @param value The integer.
+     */
+    inline void encodeInt(char* out, uint32_t value)
+    {
+        out[0] = static_cast<char>(value >> 24u);
+        out[1] = static_cast<char>(value >> 16u);
+        out[2] = static_cast<char>(value >> 8u);
+        out[3] = static_cast<char>(value);
+    }
+
+    /**
+     * Decodes an array of big-endian four-byte integers.
+     * @param source    The encoded integers.
+     * @param count     The number of integers.
+     * @param out       The decoded integers.
+     */
+    inline void decodeInts(const char* source, size_t count, uint32_t* out)
+    {
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        // Swap the shorts in each integer, then the bytes in each short
+        for (; i + 4 <= count; i += 4)
+        {
+            auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+            value      = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+            value      = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), byteSwapShorts(value));
+        }
+#endif
+
+        for (; i < count; i++)
+            out[i] = decodeInt(source + i * 4);
+    }
+
+    /**
+     * Decodes an array of big-endian two-byte integers, widening them to four bytes.
+     * @param source    The encoded integers.
+     * @param count     The number of integers.
+     * @param out       The decoded integers.
+     */
+    inline void decodeShorts(const char* source, size_t count, uint32_t* out)
+    {
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        auto zero = _mm_setzero_si128();
+        for (; i + 8 <= count; i += 8)
+        {
+            auto value = byteSwapShorts(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(value, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(value, zero));
+        }
+#endif
+
+        for (; i < count; i++)
+            out[i] = decodeShort(source + i * 2);
+    }
+
+    /**
+     * Replaces an array of deltas with their running total in place, which decodes a delta encoded id list.
+     * @param values    The deltas.
+     * @param count     The number of deltas.
+     */
+    inline void prefixSum(uint32_t* values, size_t count)
+    {
+        size_t i       = 0;
+        uint32_t total = 0;
+
+#if defined(__SSE2__)
+        // The total so far is carried from the last lane of each vector to every lane of the next
+        auto carry = _mm_setzero_si128();
+        for (; i + 4 <= count; i += 4)
+        {
+            auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+            value      = _mm_add_epi32(prefixSum(value), carry);
+            carry      = _mm_shuffle_epi32(value, _MM_SHUFFLE(3, 3, 3, 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), value);
+        }
+        total = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+#endif
+
+        for (; i < count; i++)
+            values[i] = total += values[i];
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace rsfs
+{
+    /**
+     * Gets the number of worker threads to use.
+     * @param threads   The requested number of threads, or 0 to use the number of hardware threads.
+     * @return          The number of threads.
+     */
+    inline size_t workerCount(size_t threads = 0)
+    {
+        return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * Invokes a function for every value in the range [0, count) on a thread pool, and waits for all of the
+     * invocations to complete. If any invocation throws, the first exception is rethrown once the others have
+     * completed.
+     * @param count     The number of invocations.
+     * @param function  The function to invoke with each value.
+     * @param threads   The number of worker threads, or 0 to use the number of hardware threads.
+     */
+    template<typename Function>
+    void parallelFor(size_t count, Function function, size_t threads = 0)
+    {
+        boost::asio::thread_pool pool(std::min(workerCount(threads), std::max<size_t>(count, 1)));
+        std::mutex mutex;
+        std::exception_ptr error;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            boost::asio::post(pool, [&, i] {
+                try
+                {
+                    function(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                }
+            });
+        }
+
+        pool.join();
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
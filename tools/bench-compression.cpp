@@ -0,0 +1,181 @@
+#include <rsfs/RSFileSystem.hpp>
+#include <rsfs/compression/Compression.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * Prints the usage of this tool.
+     * @param program   The name of the program.
+     */
+    void usage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " [--verify] [--threads <count>] [--level <1-9>] [--index <id>]... <cache>"
+                  << std::endl;
+    }
+
+    /**
+     * Checks that every archive decompresses back to exactly the data it was compressed from, with every compression
+     * type and level, and reports the combinations that don't.
+     * @param archives  The decompressed archives.
+     * @param threads   The number of threads to compress with, or 0 to use the number of hardware threads.
+     * @return          The number of containers that didn't decompress to the original data.
+     */
+    size_t verify(const std::vector<RSBuffer>& archives, size_t threads)
+    {
+        size_t failures = 0;
+        for (auto type = 0; type < COMPRESSION_TYPES; type++)
+        {
+            auto compression = static_cast<CompressionType>(type);
+            for (auto level = 1; level <= MAX_COMPRESSION_LEVEL; level++)
+            {
+                auto containers   = Compression::compressAll(archives, compression, threads, level);
+                size_t mismatches = 0;
+                for (size_t i = 0; i < containers.size(); i++)
+                {
+                    try
+                    {
+                        auto data = Compression::decompress(containers[i]);
+                        if (!std::equal(data.begin(), data.end(), archives[i].begin(), archives[i].end()))
+                            mismatches++;
+                    }
+                    catch (const std::exception&)
+                    {
+                        mismatches++;
+                    }
+                }
+
+                if (mismatches > 0)
+                {
+                    std::cout << Compression::typeName(compression) << " level " << level << ": " << mismatches
+                              << " archives didn't round-trip" << std::endl;
+                }
+                failures += mismatches;
+            }
+        }
+        return failures;
+    }
+
+    /**
+     * Gets the throughput of processing some data.
+     * @param bytes     The number of bytes processed.
+     * @param elapsed   The time taken.
+     * @return          The throughput, in megabytes per second.
+     */
+    double throughput(size_t bytes, std::chrono::steady_clock::duration elapsed)
+    {
+        auto seconds = std::chrono::duration<double>(elapsed).count();
+        return seconds > 0 ? bytes / seconds / (1024 * 1024) : 0;
+    }
+}
+
+/**
+ * Compresses the archives of a cache with every compression type, and reports the compression ratio and the
+ * throughput of compression and decompression. With --verify, also checks that every type and level round-trips.
+ */
+int main(int argc, char** argv)
+{
+    size_t threads = 0;
+    int level      = DEFAULT_COMPRESSION_LEVEL;
+    bool check     = false;
+    std::vector<size_t> indices;
+    std::vector<std::string> paths;
+    for (auto i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--verify") == 0)
+            check = true;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+            level = std::stoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--index") == 0 && i + 1 < argc)
+            indices.push_back(std::stoul(argv[++i]));
+        else
+            paths.emplace_back(argv[i]);
+    }
+
+    if (paths.size() != 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        RSFileSystem fs(paths[0], { .lazy = true, .ioHints = { .pattern = SEQUENTIAL } });
+        if (indices.empty())
+        {
+            for (size_t id = 0; id < fs.indexCount(); id++)
+                indices.push_back(id);
+        }
+
+        // Decompress every archive once, skipping the ones that can't be read, such as encrypted archives
+        std::vector<RSBuffer> archives;
+        size_t total = 0;
+        for (auto id: indices)
+        {
+            auto& index = fs.getIndex(id);
+            for (auto archive: index.archiveIds())
+            {
+                try
+                {
+                    auto container = index.readArchive(archive);
+                    archives.push_back(Compression::decompress(container));
+                    total += archives.back().getSize();
+                }
+                catch (const std::exception&)
+                {
+                }
+            }
+        }
+        std::cout << archives.size() << " archives, " << total << " bytes" << std::endl;
+
+        std::cout << std::left << std::setw(8) << "type" << std::right << std::setw(14) << "compressed"
+                  << std::setw(10) << "ratio" << std::setw(16) << "compress MB/s" << std::setw(18) << "decompress MB/s"
+                  << std::endl;
+        for (auto type = 0; type < COMPRESSION_TYPES; type++)
+        {
+            auto compression = static_cast<CompressionType>(type);
+            auto start       = std::chrono::steady_clock::now();
+            auto containers  = Compression::compressAll(archives, compression, threads, level);
+            auto compressed  = std::chrono::steady_clock::now() - start;
+
+            // Decompression is timed on the same number of threads as compression, so the throughputs compare
+            start             = std::chrono::steady_clock::now();
+            auto restored     = Compression::decompressAll(containers, threads);
+            auto decompressed = std::chrono::steady_clock::now() - start;
+
+            size_t size = 0;
+            for (auto& container: containers)
+                size += container.getSize();
+
+            std::cout << std::left << std::setw(8) << Compression::typeName(compression) << std::right << std::setw(14)
+                      << size << std::setw(10) << std::fixed << std::setprecision(3)
+                      << (total > 0 ? static_cast<double>(size) / total : 0) << std::setw(16) << std::setprecision(1)
+                      << throughput(total, compressed) << std::setw(18) << throughput(total, decompressed) << std::endl;
+        }
+
+        if (check)
+        {
+            auto failures = verify(archives, threads);
+            std::cout << (failures == 0 ? "Every type and level round-trips" : "Round-trip verification failed")
+                      << std::endl;
+            return failures == 0 ? 0 : 1;
+        }
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Unable to benchmark compression: " << e.what() << std::endl;
+        return 1;
+    }
+}
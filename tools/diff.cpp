@@ -0,0 +1,95 @@
+#include <rsfs/diff/CacheDiff.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * Gets the name of a change type.
+     * @param type  The change type.
+     * @return      The name.
+     */
+    const char* changeName(ChangeType type)
+    {
+        switch (type)
+        {
+            case ADDED: return "added";
+            case REMOVED: return "removed";
+            default: return "changed";
+        }
+    }
+
+    /**
+     * Prints the usage of this tool.
+     * @param program   The name of the program.
+     */
+    void usage(const char* program)
+    {
+        std::cerr << "Usage: " << program
+                  << " [--metadata-only] [--threads <count>] [--keys <path>] <old cache> <new cache>" << std::endl;
+    }
+}
+
+/**
+ * Compares two caches, and prints the indices, archives and files that differ. Exits with 0 if the caches are
+ * identical, 1 if they differ, and 2 if they couldn't be compared.
+ */
+int main(int argc, char** argv)
+{
+    DiffOptions options;
+    FileSystemOptions fsOptions;
+    std::vector<std::string> paths;
+    for (auto i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--metadata-only") == 0)
+            options.compareContents = false;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            options.threads = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc)
+            fsOptions.xteaKeys = argv[++i];
+        else
+            paths.emplace_back(argv[i]);
+    }
+
+    if (paths.size() != 2)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        RSFileSystem from(paths[0], fsOptions);
+        RSFileSystem to(paths[1], fsOptions);
+        auto diff = CacheDiff::compare(from, to, options);
+
+        for (auto&& index: diff.indices())
+        {
+            std::cout << "index " << index.id << ": " << changeName(index.type) << " (revision " << index.oldRevision
+                      << " -> " << index.newRevision << ")" << std::endl;
+            for (auto&& archive: index.archives)
+            {
+                std::cout << "  archive " << archive.id << ": " << changeName(archive.type) << " (revision "
+                          << archive.oldRevision << " -> " << archive.newRevision << ")";
+                if (archive.compressedOnly)
+                    std::cout << ", couldn't be decompressed";
+                if (archive.renamed)
+                    std::cout << ", renamed";
+                std::cout << std::endl;
+                for (auto&& file: archive.files)
+                    std::cout << "    file " << file.id << ": " << changeName(file.type) << std::endl;
+            }
+        }
+        return diff.empty() ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Unable to compare caches: " << e.what() << std::endl;
+        return 2;
+    }
+}
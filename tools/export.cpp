@@ -0,0 +1,70 @@
+#include <rsfs/export/CacheExporter.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * Prints the usage of this tool.
+     * @param program   The name of the program.
+     */
+    void usage(const char* program)
+    {
+        std::cerr << "Usage: " << program
+                  << " [--packed] [--skip-errors] [--threads <count>] [--index <id>]... [--keys <path>] <cache> <output>"
+                  << std::endl;
+    }
+}
+
+/**
+ * Exports the files of a cache to a directory tree or a packed file.
+ */
+int main(int argc, char** argv)
+{
+    ExportOptions options;
+    FileSystemOptions fsOptions{ .ioHints = { .pattern = SEQUENTIAL } };
+    std::vector<std::string> paths;
+    for (auto i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--packed") == 0)
+            options.format = PACKED;
+        else if (std::strcmp(argv[i], "--skip-errors") == 0)
+            options.skipErrors = true;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            options.threads = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--index") == 0 && i + 1 < argc)
+            options.indices.push_back(std::stoul(argv[++i]));
+        else if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc)
+            fsOptions.xteaKeys = argv[++i];
+        else
+            paths.emplace_back(argv[i]);
+    }
+
+    if (paths.size() != 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        RSFileSystem fs(paths[0], fsOptions);
+        auto stats = CacheExporter::write(fs, paths[1], options);
+        std::cout << "Exported " << stats.files << " files (" << stats.bytes << " bytes) from " << stats.archives
+                  << " archives";
+        if (stats.failures != 0)
+            std::cout << ", skipped " << stats.failures << " archives";
+        std::cout << std::endl;
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Unable to export cache: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,110 @@
+#include <rsfs/optimise/CacheOptimiser.hpp>
+#include <rsfs/store/FlatFileStore.hpp>
+#include <rsfs/store/SectorStore.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * Prints the usage of this tool.
+     * @param program   The name of the program.
+     */
+    void usage(const char* program)
+    {
+        std::cerr << "Usage: " << program
+                  << " [--flat] [--threads <count>] [--type <none|bzip2|gzip|lzma>]... [--level <1-9>]... "
+                     "[--keys <path>] <cache> <output>"
+                  << std::endl;
+    }
+
+    /**
+     * Parses the name of a compression type.
+     * @param name  The name of the type.
+     * @return      The compression type.
+     */
+    CompressionType parseType(const char* name)
+    {
+        for (auto type = 0; type < COMPRESSION_TYPES; type++)
+        {
+            if (std::strcmp(Compression::typeName(static_cast<CompressionType>(type)), name) == 0)
+                return static_cast<CompressionType>(type);
+        }
+        throw std::invalid_argument(std::string("Unknown compression type ") + name);
+    }
+}
+
+/**
+ * Rewrites a cache with the smallest container for each archive.
+ */
+int main(int argc, char** argv)
+{
+    OptimiseOptions options;
+    FileSystemOptions fsOptions{ .ioHints = { .pattern = SEQUENTIAL } };
+    std::vector<CompressionType> types;
+    std::vector<int> levels;
+    std::vector<std::string> paths;
+    auto flat = false;
+    try
+    {
+        for (auto i = 1; i < argc; i++)
+        {
+            if (std::strcmp(argv[i], "--flat") == 0)
+                flat = true;
+            else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+                options.threads = std::stoul(argv[++i]);
+            else if (std::strcmp(argv[i], "--type") == 0 && i + 1 < argc)
+                types.push_back(parseType(argv[++i]));
+            else if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+                levels.push_back(std::stoi(argv[++i]));
+            else if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc)
+                fsOptions.xteaKeys = argv[++i];
+            else
+                paths.emplace_back(argv[i]);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (paths.size() != 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!types.empty())
+        options.types = types;
+    if (!levels.empty())
+        options.levels = levels;
+
+    try
+    {
+        RSFileSystem fs(paths[0], fsOptions);
+        std::unique_ptr<Store> out;
+        if (flat)
+            out = std::make_unique<FlatFileStore>(paths[1]);
+        else
+            out = SectorStore::create(paths[1]);
+
+        auto stats = CacheOptimiser::write(fs, *out, options);
+        std::cout << "Recompressed " << stats.recompressed << " of " << stats.archives << " archives, "
+                  << stats.bytesBefore << " -> " << stats.bytesAfter << " bytes";
+        if (stats.skipped != 0)
+            std::cout << ", copied " << stats.skipped << " encrypted or unreadable archives";
+        std::cout << std::endl;
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Unable to optimise cache: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,91 @@
+#include <rsfs/report/CacheReporter.hpp>
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace rsfs;
+
+namespace
+{
+    /**
+     * Prints the usage of this tool.
+     * @param program   The name of the program.
+     */
+    void usage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " [--json] [--keys <path>] <cache>" << std::endl;
+    }
+
+    /**
+     * Prints a row of the report table.
+     * @param name  The name of the row.
+     * @param stats The statistics of the row.
+     */
+    void printRow(const std::string& name, const IndexStats& stats)
+    {
+        std::cout << std::setw(6) << name << std::setw(10) << stats.archives << std::setw(14) << stats.bytes
+                  << std::setw(10) << stats.sectors << std::setw(11) << std::fixed << std::setprecision(1)
+                  << stats.sectorUtilisation() * 100 << '%' << std::setw(12) << std::setprecision(3)
+                  << stats.averageDiscontinuity() << std::setw(8) << stats.brokenChains << std::setw(8)
+                  << std::setprecision(3) << stats.compressionRatio();
+        for (auto count: stats.compressionTypes)
+            std::cout << std::setw(8) << count;
+        std::cout << std::endl;
+    }
+}
+
+/**
+ * Reports how a cache is laid out on disk.
+ */
+int main(int argc, char** argv)
+{
+    auto json = false;
+    FileSystemOptions fsOptions{ .lazy = true };
+    std::vector<std::string> paths;
+    for (auto i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc)
+            fsOptions.xteaKeys = argv[++i];
+        else
+            paths.emplace_back(argv[i]);
+    }
+
+    if (paths.size() != 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        RSFileSystem fs(paths[0], fsOptions);
+        auto report = CacheReporter::analyse(fs);
+        if (json)
+        {
+            std::cout << CacheReporter::toJson(report) << std::endl;
+            return 0;
+        }
+
+        std::cout << std::setw(6) << "index" << std::setw(10) << "archives" << std::setw(14) << "bytes"
+                  << std::setw(10) << "sectors" << std::setw(12) << "utilisation" << std::setw(12) << "jumps/arch"
+                  << std::setw(8) << "broken" << std::setw(8) << "ratio" << std::setw(8) << "none" << std::setw(8)
+                  << "bzip2" << std::setw(8) << "gzip" << std::setw(8) << "lzma" << std::endl;
+        for (auto& stats: report.indices)
+            if (stats.archives > 0)
+                printRow(std::to_string(stats.index), stats);
+        printRow("total", report.total);
+
+        std::cout << report.unusedSectors << " of " << report.dataSectors << " sectors are unused" << std::endl;
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Unable to report cache: " << e.what() << std::endl;
+        return 1;
+    }
+}